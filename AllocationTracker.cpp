@@ -0,0 +1,142 @@
+#include "AllocationTracker.h"
+
+#include <cstring>
+
+#ifdef ENABLE_ALLOCATION_TRACKING
+#include <cstdlib>
+#include <new>
+
+namespace {
+	// operator new の中から使うので自明な初期化の変数だけにする
+	thread_local uint64_t allocationCount = 0;
+	thread_local uint64_t allocationBytes = 0;
+
+	void* Allocate(const std::size_t size) {
+		++allocationCount;
+		allocationBytes += size;
+		if (void* memory = std::malloc(size != 0 ? size : 1)) {
+			return memory;
+		}
+		throw std::bad_alloc();
+	}
+
+	void* AllocateAligned(const std::size_t size, const std::align_val_t alignment) {
+		++allocationCount;
+		allocationBytes += size;
+		const std::size_t align = static_cast<std::size_t>(alignment);
+#ifdef _MSC_VER
+		void* memory = _aligned_malloc(size != 0 ? size : 1, align);
+#else
+		// aligned_alloc はサイズがアラインメントの倍数である必要がある
+		void* memory = std::aligned_alloc(align, (size + align - 1) / align * align);
+#endif
+		if (memory == nullptr) {
+			throw std::bad_alloc();
+		}
+		return memory;
+	}
+
+	void FreeAligned(void* memory) noexcept {
+#ifdef _MSC_VER
+		_aligned_free(memory);
+#else
+		std::free(memory);
+#endif
+	}
+}
+
+void* operator new(const std::size_t size) {
+	return Allocate(size);
+}
+
+void* operator new[](const std::size_t size) {
+	return Allocate(size);
+}
+
+void* operator new(const std::size_t size, const std::align_val_t alignment) {
+	return AllocateAligned(size, alignment);
+}
+
+void* operator new[](const std::size_t size, const std::align_val_t alignment) {
+	return AllocateAligned(size, alignment);
+}
+
+void operator delete(void* memory) noexcept {
+	std::free(memory);
+}
+
+void operator delete[](void* memory) noexcept {
+	std::free(memory);
+}
+
+void operator delete(void* memory, std::size_t) noexcept {
+	std::free(memory);
+}
+
+void operator delete[](void* memory, std::size_t) noexcept {
+	std::free(memory);
+}
+
+void operator delete(void* memory, std::align_val_t) noexcept {
+	FreeAligned(memory);
+}
+
+void operator delete[](void* memory, std::align_val_t) noexcept {
+	FreeAligned(memory);
+}
+
+void operator delete(void* memory, std::size_t, std::align_val_t) noexcept {
+	FreeAligned(memory);
+}
+
+void operator delete[](void* memory, std::size_t, std::align_val_t) noexcept {
+	FreeAligned(memory);
+}
+
+AllocationCounters GetThreadAllocations() {
+	return {allocationCount, allocationBytes};
+}
+#else
+AllocationCounters GetThreadAllocations() {
+	return {};
+}
+#endif
+
+AllocationTracker* AllocationTracker::GetInstance() {
+	static AllocationTracker instance;
+	return &instance;
+}
+
+void AllocationTracker::NewFrame() {
+	for (uint32_t i = 0; i < phaseCount_; ++i) {
+		phases_[i].last = phases_[i].current;
+		phases_[i].current = {};
+	}
+}
+
+void AllocationTracker::Add(const char* phase, const AllocationCounters& counters) {
+	// 同じリテラルでも翻訳単位が違うとアドレスが変わりうるので文字列で比べる
+	uint32_t index = 0;
+	while (index < phaseCount_ && std::strcmp(phases_[index].name, phase) != 0) {
+		++index;
+	}
+
+	if (index == phaseCount_) {
+		if (phaseCount_ == kMaxPhases) {
+			return;
+		}
+		phases_[phaseCount_++].name = phase;
+	}
+
+	phases_[index].current.count += counters.count;
+	phases_[index].current.bytes += counters.bytes;
+}
+
+AllocationCounters AllocationTracker::GetLastFrameTotal() const {
+	AllocationCounters total;
+	for (uint32_t i = 0; i < phaseCount_; ++i) {
+		total.count += phases_[i].last.count;
+		total.bytes += phases_[i].last.bytes;
+	}
+	return total;
+}
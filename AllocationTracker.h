@@ -0,0 +1,98 @@
+#pragma once
+#include <array>
+#include <cstdint>
+
+// ENABLE_ALLOCATION_TRACKING が定義されているときだけグローバルな operator new を置き換えて
+// ヒープ確保を数えます。定義されていないときマクロは何も生成しません
+#ifdef ENABLE_ALLOCATION_TRACKING
+#define ALLOCATION_CONCAT_INNER(a, b) a##b
+#define ALLOCATION_CONCAT(a, b) ALLOCATION_CONCAT_INNER(a, b)
+// スコープ内で呼び出し元スレッドが行ったヒープ確保をフェーズnameに加算する (nameは文字列リテラル)
+#define ALLOCATION_SCOPE(name) const AllocationScope ALLOCATION_CONCAT(allocationScope_, __LINE__)(name)
+// フレームの区切り (メインループの先頭で呼ぶ)
+#define ALLOCATION_FRAME() AllocationTracker::GetInstance()->NewFrame()
+#else
+#define ALLOCATION_SCOPE(name) ((void)0)
+#define ALLOCATION_FRAME() ((void)0)
+#endif
+
+/// <summary>
+/// ヒープ確保の回数と量
+/// </summary>
+struct AllocationCounters {
+	uint64_t count = 0;
+	uint64_t bytes = 0;
+};
+
+/// <summary>
+/// 呼び出し元スレッドでこれまでに行われたヒープ確保の累計
+/// ENABLE_ALLOCATION_TRACKING が無効なら常に0
+/// </summary>
+AllocationCounters GetThreadAllocations();
+
+/// <summary>
+/// フェーズごとのヒープ確保の集計 (メインスレッド用)
+/// 集計表は固定長なので、集計そのものはヒープを使いません
+/// </summary>
+class AllocationTracker {
+public:
+	static constexpr uint32_t kMaxPhases = 32;
+
+	struct Phase {
+		const char* name = nullptr;
+		AllocationCounters current; // 集計中のフレーム
+		AllocationCounters last; // 直前に終わったフレーム
+	};
+
+	static AllocationTracker* GetInstance();
+
+	/// <summary>
+	/// 集計中のフレームを締めてlastに移します
+	/// </summary>
+	void NewFrame();
+
+	/// <summary>
+	/// フェーズに確保を加算します
+	/// </summary>
+	void Add(const char* phase, const AllocationCounters& counters);
+
+	/// <summary>
+	/// 直前のフレームの全フェーズ合計 (フェーズを入れ子にすると二重に数えます)
+	/// </summary>
+	AllocationCounters GetLastFrameTotal() const;
+
+	const Phase* GetPhases() const {
+		return phases_.data();
+	}
+
+	uint32_t GetPhaseCount() const {
+		return phaseCount_;
+	}
+
+private:
+	AllocationTracker() = default;
+
+	std::array<Phase, kMaxPhases> phases_ = {};
+	uint32_t phaseCount_ = 0;
+};
+
+/// <summary>
+/// 生成から破棄までの確保をフェーズに加算します
+/// ALLOCATION_SCOPE マクロから使います
+/// </summary>
+class AllocationScope {
+public:
+	explicit AllocationScope(const char* phase) : phase_(phase), begin_(GetThreadAllocations()) {}
+
+	~AllocationScope() {
+		const AllocationCounters end = GetThreadAllocations();
+		AllocationTracker::GetInstance()->Add(phase_, {end.count - begin_.count, end.bytes - begin_.bytes});
+	}
+
+	AllocationScope(const AllocationScope&) = delete;
+	AllocationScope& operator=(const AllocationScope&) = delete;
+
+private:
+	const char* phase_;
+	AllocationCounters begin_;
+};
@@ -0,0 +1,91 @@
+#pragma once
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include "Vec3.h"
+
+// 親がいないことを表す添字
+inline constexpr uint32_t kNoParent = UINT32_MAX;
+
+// 衝突レイヤーの既定値と、すべてのレイヤーに当たるマスク
+inline constexpr uint32_t kDefaultLayer = 1;
+inline constexpr uint32_t kAllLayers = UINT32_MAX;
+
+/// <summary>
+/// 剛体の状態を種類ごとの配列で保持します (SoA)
+/// 同じ添字が同じ剛体を指します
+/// </summary>
+struct BodyArrays {
+	std::vector<Vec3> positions;
+	std::vector<Vec3> velocities;
+	std::vector<Vec3> pseudoVelocities; // めり込み解消用の疑似速度 (運動量には含めない)
+	std::vector<Vec3> forces;
+	std::vector<float> masses;
+	std::vector<float> inverseMasses; // スタティックなら0
+	std::vector<float> radii;
+	std::vector<float> restitutions;
+
+	// 衝突のふるい分け (layers[a] & masks[b] と layers[b] & masks[a] が両方0でなければ衝突する)
+	std::vector<uint32_t> layers;
+	std::vector<uint32_t> masks;
+	// トリガーなら1 (ブロードフェーズには参加するが、ソルバーでは解かない)
+	std::vector<uint8_t> triggers;
+
+	// 親との距離拘束
+	std::vector<uint32_t> parents;
+	std::vector<float> maxDistances;
+
+	uint32_t Size() const {
+		return static_cast<uint32_t>(positions.size());
+	}
+
+	void Resize(const uint32_t count) {
+		positions.resize(count);
+		velocities.resize(count);
+		pseudoVelocities.resize(count);
+		forces.resize(count);
+		masses.resize(count);
+		inverseMasses.resize(count);
+		radii.resize(count);
+		restitutions.resize(count);
+		layers.resize(count, kDefaultLayer);
+		masks.resize(count, kAllLayers);
+		triggers.resize(count, 0);
+		parents.resize(count, kNoParent);
+		maxDistances.resize(count);
+	}
+
+	void Clear() {
+		Resize(0);
+	}
+};
+
+/// <summary>
+/// 処理対象の剛体の指定
+/// indicesが空なら [begin, end) の連続範囲、そうでなければ添字リストを使います
+/// </summary>
+struct BodySelection {
+	uint32_t begin = 0;
+	uint32_t end = UINT32_MAX;
+	std::span<const uint32_t> indices;
+
+	static BodySelection All() {
+		return {};
+	}
+
+	static BodySelection Range(const uint32_t first, const uint32_t last) {
+		return {first, last, {}};
+	}
+
+	static BodySelection List(const std::span<const uint32_t> list) {
+		return {0, 0, list};
+	}
+
+	/// <summary>
+	/// すべての剛体を指しているか (添字の並びに依存しないか)
+	/// </summary>
+	bool IsAll() const {
+		return indices.empty() && begin == 0 && end == UINT32_MAX;
+	}
+};
@@ -32,13 +32,6 @@ ViewProjection* Camera::GetViewProjection() const {
 	return viewProjection_;
 }
 
-Vec3 Camera::TransformNormal(const Vec3 v, const Mat4& m) {
-	return {
-		   v.x * m.m[0][0] + v.y * m.m[1][0] + v.z * m.m[2][0], v.x * m.m[0][1] + v.y * m.m[1][1] + v.z * m.m[2][1],
-		   v.x * m.m[0][2] + v.y * m.m[1][2] + v.z * m.m[2][2]
-	};
-}
-
 void Camera::Details() {
 	Object::Details();
 
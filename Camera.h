@@ -20,8 +20,6 @@ public:
 
 	ViewProjection* GetViewProjection() const;
 
-	static Vec3 TransformNormal(const Vec3 v, const Mat4& m);
-
 	void Details() override;
 
 	float GetZoom() const;
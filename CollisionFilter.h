@@ -0,0 +1,85 @@
+#pragma once
+#include <algorithm>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include "BodyArrays.h"
+
+/// <summary>
+/// 衝突させない剛体の組の集合
+/// 並べ替えても増えたり確保し直したりしないよう、ソート済みの配列で持ちます
+/// </summary>
+class IgnoredPairSet {
+public:
+	void Add(const uint32_t a, const uint32_t b) {
+		const uint64_t key = MakeKey(a, b);
+		const auto it = std::lower_bound(keys_.begin(), keys_.end(), key);
+		if (it == keys_.end() || *it != key) {
+			keys_.insert(it, key);
+		}
+	}
+
+	void Remove(const uint32_t a, const uint32_t b) {
+		const uint64_t key = MakeKey(a, b);
+		const auto it = std::lower_bound(keys_.begin(), keys_.end(), key);
+		if (it != keys_.end() && *it == key) {
+			keys_.erase(it);
+		}
+	}
+
+	bool Contains(const uint32_t a, const uint32_t b) const {
+		return std::binary_search(keys_.begin(), keys_.end(), MakeKey(a, b));
+	}
+
+	bool IsEmpty() const {
+		return keys_.empty();
+	}
+
+	/// <summary>
+	/// 剛体を並べ替えたあと、新しい添字に付け替えます
+	/// </summary>
+	/// <param name="newIndices">元の添字から新しい添字への表</param>
+	void Remap(const std::span<const uint32_t> newIndices) {
+		for (uint64_t& key : keys_) {
+			key = MakeKey(newIndices[static_cast<uint32_t>(key >> 32)], newIndices[static_cast<uint32_t>(key)]);
+		}
+		std::sort(keys_.begin(), keys_.end());
+	}
+
+	void Clear() {
+		keys_.clear();
+	}
+
+private:
+	// 小さい方の添字を上位に詰めるので、組の順番によらない
+	static uint64_t MakeKey(const uint32_t a, const uint32_t b) {
+		return (static_cast<uint64_t>(std::min(a, b)) << 32) | std::max(a, b);
+	}
+
+	std::vector<uint64_t> keys_;
+};
+
+/// <summary>
+/// ブロードフェーズの中で、距離を測る前にペアをふるい落とす条件
+/// 互いのレイヤーが相手のマスクに含まれるときだけ衝突します
+/// </summary>
+struct CollisionFilter {
+	std::span<const uint32_t> layers;
+	std::span<const uint32_t> masks;
+	std::span<const uint32_t> parents; // 空でなければ親子は衝突しない
+	const IgnoredPairSet* ignoredPairs = nullptr;
+
+	/// <summary>
+	/// 剛体aとbを衝突させるか
+	/// </summary>
+	bool ShouldCollide(const uint32_t a, const uint32_t b) const {
+		if ((layers[a] & masks[b]) == 0 || (layers[b] & masks[a]) == 0) {
+			return false;
+		}
+		if (!parents.empty() && (parents[a] == b || parents[b] == a)) {
+			return false;
+		}
+		return ignoredPairs == nullptr || ignoredPairs->IsEmpty() || !ignoredPairs->Contains(a, b);
+	}
+};
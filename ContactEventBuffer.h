@@ -0,0 +1,107 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <span>
+#include <utility>
+#include <vector>
+
+#include "Vec3.h"
+
+/// <summary>
+/// 1ステップ分の接触の通知 (音やダメージ、エフェクト用)
+/// </summary>
+struct ContactEvent {
+	uint32_t a; // 剛体のハンドル
+	uint32_t b;
+	Vec3 point; // 接触点 (めり込みの中間)
+	Vec3 normal; // aからbへ向かう法線
+	float impulse; // そのステップで法線方向に加えた撃力の合計
+};
+
+/// <summary>
+/// 接触の通知をためる固定長の配列
+/// 書き込む位置をアトミックに進めるだけなので、複数のスレッドからロックなしで追加できます
+/// (PhysicsWorldは1スレッドからペアの順に追加するので、並びは毎回同じです)
+/// 容量はステップの前に決め、ステップ中は確保しません
+/// </summary>
+class ContactEventBuffer {
+public:
+	ContactEventBuffer() = default;
+
+	// 追加の途中でなければ、持ち主ごとコピーやムーブができる
+	ContactEventBuffer(const ContactEventBuffer& other) {
+		*this = other;
+	}
+
+	ContactEventBuffer(ContactEventBuffer&& other) noexcept {
+		*this = std::move(other);
+	}
+
+	ContactEventBuffer& operator=(const ContactEventBuffer& other) {
+		events_ = other.events_;
+		CopyCounters(other);
+		return *this;
+	}
+
+	ContactEventBuffer& operator=(ContactEventBuffer&& other) noexcept {
+		events_ = std::move(other.events_);
+		CopyCounters(other);
+		// 移動元は配列を失ったので空にしておく
+		other.Reset(0);
+		return *this;
+	}
+
+	/// <summary>
+	/// 空にして、このステップで受け付ける最大数を決めます
+	/// 前より大きいときだけ配列を広げます
+	/// </summary>
+	void Reset(const uint32_t capacity) {
+		if (events_.size() < capacity) {
+			events_.resize(capacity);
+		}
+		capacity_ = capacity;
+		count_.store(0, std::memory_order_relaxed);
+		droppedCount_.store(0, std::memory_order_relaxed);
+	}
+
+	/// <summary>
+	/// 通知を追加します (複数のスレッドから同時に呼べます)
+	/// </summary>
+	/// <returns>満杯で捨てたらfalse</returns>
+	bool Push(const ContactEvent& event) {
+		const uint32_t index = count_.fetch_add(1, std::memory_order_relaxed);
+		if (index >= capacity_) {
+			droppedCount_.fetch_add(1, std::memory_order_relaxed);
+			return false;
+		}
+		events_[index] = event;
+		return true;
+	}
+
+	/// <summary>
+	/// たまった通知 (追加が終わってから読むこと)
+	/// </summary>
+	std::span<const ContactEvent> GetEvents() const {
+		return {events_.data(), std::min(count_.load(std::memory_order_relaxed), capacity_)};
+	}
+
+	/// <summary>
+	/// 満杯で捨てた数
+	/// </summary>
+	uint32_t GetDroppedCount() const {
+		return droppedCount_.load(std::memory_order_relaxed);
+	}
+
+private:
+	void CopyCounters(const ContactEventBuffer& other) {
+		capacity_ = other.capacity_;
+		count_.store(other.count_.load(std::memory_order_relaxed), std::memory_order_relaxed);
+		droppedCount_.store(other.droppedCount_.load(std::memory_order_relaxed), std::memory_order_relaxed);
+	}
+
+	std::vector<ContactEvent> events_;
+	uint32_t capacity_ = 0;
+	std::atomic<uint32_t> count_ = 0;
+	std::atomic<uint32_t> droppedCount_ = 0;
+};
@@ -0,0 +1,189 @@
+#include "ForceGenerator.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace {
+	/// <summary>
+	/// 選択された剛体ごとにfuncを呼びます
+	/// 連続範囲ならそのままループするのでコンパイラがベクトル化できます
+	/// </summary>
+	template <typename Func>
+	void ForEachSelected(const BodySelection& selection, const uint32_t count, Func&& func) {
+		if (!selection.indices.empty()) {
+			for (const uint32_t i : selection.indices) {
+				func(i);
+			}
+			return;
+		}
+
+		const uint32_t end = std::min(selection.end, count);
+		for (uint32_t i = selection.begin; i < end; ++i) {
+			func(i);
+		}
+	}
+}
+
+void ApplyForce(const UniformGravity& generator, BodyArrays& bodies) {
+	Vec3* forces = bodies.forces.data();
+	const float* masses = bodies.masses.data();
+	ForEachSelected(generator.bodies, bodies.Size(), [&](const uint32_t i) {
+		forces[i] += generator.acceleration * masses[i];
+	});
+}
+
+void ApplyForce(const UniformForce& generator, BodyArrays& bodies) {
+	Vec3* forces = bodies.forces.data();
+	ForEachSelected(generator.bodies, bodies.Size(), [&](const uint32_t i) {
+		forces[i] += generator.force;
+	});
+}
+
+void ApplyForce(const LinearDrag& generator, BodyArrays& bodies) {
+	Vec3* forces = bodies.forces.data();
+	const Vec3* velocities = bodies.velocities.data();
+	ForEachSelected(generator.bodies, bodies.Size(), [&](const uint32_t i) {
+		forces[i] -= velocities[i] * generator.coefficient;
+	});
+}
+
+void ApplyForce(const QuadraticDrag& generator, BodyArrays& bodies) {
+	Vec3* forces = bodies.forces.data();
+	const Vec3* velocities = bodies.velocities.data();
+	ForEachSelected(generator.bodies, bodies.Size(), [&](const uint32_t i) {
+		forces[i] -= velocities[i] * (velocities[i].Length() * generator.coefficient);
+	});
+}
+
+void ApplyForce(const PointAttractor& generator, BodyArrays& bodies) {
+	Vec3* forces = bodies.forces.data();
+	const Vec3* positions = bodies.positions.data();
+	const float* masses = bodies.masses.data();
+	const float minSqrDistance = generator.minDistance * generator.minDistance;
+	ForEachSelected(generator.bodies, bodies.Size(), [&](const uint32_t i) {
+		const Vec3 delta = generator.center - positions[i];
+		const float sqrDistance = std::max(delta.SqrtLength(), minSqrDistance);
+		// delta / |delta|^3 で方向と逆2乗をまとめて求める
+		const float invDistance = 1.0f / std::sqrt(sqrDistance);
+		forces[i] += delta * (generator.strength * masses[i] * invDistance * invDistance * invDistance);
+	});
+}
+
+void ApplyForce(const WindField& generator, BodyArrays& bodies) {
+	Vec3* forces = bodies.forces.data();
+	const Vec3* velocities = bodies.velocities.data();
+	ForEachSelected(generator.bodies, bodies.Size(), [&](const uint32_t i) {
+		forces[i] += (generator.velocity - velocities[i]) * generator.coefficient;
+	});
+}
+
+void ApplySprings(const std::span<const Spring> springs, BodyArrays& bodies) {
+	Vec3* forces = bodies.forces.data();
+	const Vec3* positions = bodies.positions.data();
+	const Vec3* velocities = bodies.velocities.data();
+	for (const Spring& spring : springs) {
+		const Vec3 delta = positions[spring.b] - positions[spring.a];
+		const float length = delta.Length();
+		if (length <= 0.0f) {
+			continue;
+		}
+
+		const Vec3 direction = delta / length;
+		const float relativeSpeed = (velocities[spring.b] - velocities[spring.a]).DotProduct(direction);
+		const float magnitude = spring.stiffness * (length - spring.restLength) + spring.damping * relativeSpeed;
+
+		const Vec3 force = direction * magnitude;
+		forces[spring.a] += force;
+		forces[spring.b] -= force;
+	}
+}
+
+void ForceGeneratorSet::Apply(BodyArrays& bodies) const {
+	for (const UniformGravity& generator : gravities) {
+		ApplyForce(generator, bodies);
+	}
+	for (const UniformForce& generator : uniformForces) {
+		ApplyForce(generator, bodies);
+	}
+	for (const LinearDrag& generator : linearDrags) {
+		ApplyForce(generator, bodies);
+	}
+	for (const QuadraticDrag& generator : quadraticDrags) {
+		ApplyForce(generator, bodies);
+	}
+	for (const PointAttractor& generator : attractors) {
+		ApplyForce(generator, bodies);
+	}
+	for (const WindField& generator : winds) {
+		ApplyForce(generator, bodies);
+	}
+	ApplySprings(springs, bodies);
+}
+
+float ForceGeneratorSet::ComputePotentialEnergy(const BodyArrays& bodies) const {
+	float energy = 0.0f;
+	const Vec3* positions = bodies.positions.data();
+	const float* masses = bodies.masses.data();
+	const float* inverseMasses = bodies.inverseMasses.data();
+
+	for (const UniformGravity& generator : gravities) {
+		ForEachSelected(generator.bodies, bodies.Size(), [&](const uint32_t i) {
+			if (inverseMasses[i] > 0.0f) {
+				energy -= masses[i] * generator.acceleration.DotProduct(positions[i]);
+			}
+		});
+	}
+
+	for (const UniformForce& generator : uniformForces) {
+		ForEachSelected(generator.bodies, bodies.Size(), [&](const uint32_t i) {
+			if (inverseMasses[i] > 0.0f) {
+				energy -= generator.force.DotProduct(positions[i]);
+			}
+		});
+	}
+
+	for (const PointAttractor& generator : attractors) {
+		ForEachSelected(generator.bodies, bodies.Size(), [&](const uint32_t i) {
+			if (inverseMasses[i] > 0.0f) {
+				const float distance = std::max((generator.center - positions[i]).Length(), generator.minDistance);
+				energy -= generator.strength * masses[i] / distance;
+			}
+		});
+	}
+
+	for (const Spring& spring : springs) {
+		const float stretch = (positions[spring.b] - positions[spring.a]).Length() - spring.restLength;
+		energy += 0.5f * spring.stiffness * stretch * stretch;
+	}
+
+	return energy;
+}
+
+bool ForceGeneratorSet::HasPartialSelections() const {
+	const auto IsPartial = [](const auto& generator) {
+		return !generator.bodies.IsAll();
+	};
+	return std::any_of(gravities.begin(), gravities.end(), IsPartial) ||
+		std::any_of(uniformForces.begin(), uniformForces.end(), IsPartial) ||
+		std::any_of(linearDrags.begin(), linearDrags.end(), IsPartial) ||
+		std::any_of(quadraticDrags.begin(), quadraticDrags.end(), IsPartial) ||
+		std::any_of(attractors.begin(), attractors.end(), IsPartial) ||
+		std::any_of(winds.begin(), winds.end(), IsPartial);
+}
+
+void ForceGeneratorSet::RemapBodies(const std::span<const uint32_t> newIndices) {
+	for (Spring& spring : springs) {
+		spring.a = newIndices[spring.a];
+		spring.b = newIndices[spring.b];
+	}
+}
+
+void ForceGeneratorSet::Clear() {
+	gravities.clear();
+	uniformForces.clear();
+	linearDrags.clear();
+	quadraticDrags.clear();
+	attractors.clear();
+	winds.clear();
+	springs.clear();
+}
@@ -0,0 +1,116 @@
+#pragma once
+#include <vector>
+
+#include "BodyArrays.h"
+
+/// <summary>
+/// 一様な重力 (質量に比例する力)
+/// </summary>
+struct UniformGravity {
+	Vec3 acceleration;
+	BodySelection bodies;
+};
+
+/// <summary>
+/// 質量によらない一定の力 (重いものほどゆっくり加速する)
+/// </summary>
+struct UniformForce {
+	Vec3 force;
+	BodySelection bodies;
+};
+
+/// <summary>
+/// 速度に比例する抵抗 F = -k v
+/// </summary>
+struct LinearDrag {
+	float coefficient = 0.0f;
+	BodySelection bodies;
+};
+
+/// <summary>
+/// 速度の2乗に比例する抵抗 F = -k |v| v
+/// </summary>
+struct QuadraticDrag {
+	float coefficient = 0.0f;
+	BodySelection bodies;
+};
+
+/// <summary>
+/// 点に向かって距離の2乗に反比例して引き寄せる
+/// </summary>
+struct PointAttractor {
+	Vec3 center;
+	float strength = 0.0f;
+	float minDistance = 0.1f; // これより近いときは発散を防ぐためこの距離として扱う
+	BodySelection bodies;
+};
+
+/// <summary>
+/// 風との相対速度に比例する力 F = k (wind - v)
+/// </summary>
+struct WindField {
+	Vec3 velocity;
+	float coefficient = 0.0f;
+	BodySelection bodies;
+};
+
+/// <summary>
+/// 二つの剛体をつなぐバネ
+/// </summary>
+struct Spring {
+	uint32_t a = 0;
+	uint32_t b = 0;
+	float restLength = 0.0f;
+	float stiffness = 0.0f;
+	float damping = 0.0f;
+};
+
+/// <summary>
+/// 各フォースを対象の剛体にまとめて加えます
+/// </summary>
+void ApplyForce(const UniformGravity& generator, BodyArrays& bodies);
+void ApplyForce(const UniformForce& generator, BodyArrays& bodies);
+void ApplyForce(const LinearDrag& generator, BodyArrays& bodies);
+void ApplyForce(const QuadraticDrag& generator, BodyArrays& bodies);
+void ApplyForce(const PointAttractor& generator, BodyArrays& bodies);
+void ApplyForce(const WindField& generator, BodyArrays& bodies);
+void ApplySprings(std::span<const Spring> springs, BodyArrays& bodies);
+
+/// <summary>
+/// フォースジェネレーターの集合
+/// 種類ごとに配列で持ち、種類ごとに1パスで適用します
+/// </summary>
+class ForceGeneratorSet {
+public:
+	std::vector<UniformGravity> gravities;
+	std::vector<UniformForce> uniformForces;
+	std::vector<LinearDrag> linearDrags;
+	std::vector<QuadraticDrag> quadraticDrags;
+	std::vector<PointAttractor> attractors;
+	std::vector<WindField> winds;
+	std::vector<Spring> springs;
+
+	/// <summary>
+	/// すべてのフォースをbodies.forcesに加算します
+	/// </summary>
+	void Apply(BodyArrays& bodies) const;
+
+	/// <summary>
+	/// 保存力 (重力・一定の力・引力点・バネ) の位置エネルギーを返します
+	/// </summary>
+	float ComputePotentialEnergy(const BodyArrays& bodies) const;
+
+	/// <summary>
+	/// 全体以外 (範囲や添字リスト) を対象にするフォースがあるか
+	/// あると剛体の並べ替えで対象がずれるので、PhysicsWorldは並べ替えを行いません
+	/// </summary>
+	bool HasPartialSelections() const;
+
+	/// <summary>
+	/// 剛体を並べ替えたあと、バネの両端を新しい添字に付け替えます
+	/// </summary>
+	/// <param name="newIndices">元の添字から新しい添字への表</param>
+	void RemapBodies(std::span<const uint32_t> newIndices);
+
+	void Clear();
+};
@@ -0,0 +1,370 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "AllocationTracker.h"
+#include "PhysicsWorld.h"
+#include "Profiler.h"
+#include "SceneDescription.h"
+#include "ThreadPool.h"
+#include "WorldSweep.h"
+
+// ウィンドウもD3D12も使わずにシーンを進めて計測するコマンドラインツール
+//
+//   HeadlessRunner [--scene <file> | --chain <links> | --pile <bodies>] [--steps <n>] [--interval <n>]
+//                  [--gravity <g>] [--state <file>] [--save-scene <file>] [--trace <file>]
+//                  [--check-alloc <warmup steps>] [--reorder <interval>] [--broadphase <grid|lbvh|verlet>]
+//                  [--contact-events <min impulse>]
+//                  [--sweep [--reductions <a,b,..>] [--restitutions <a,b,..>] [--mass-ratios <a,b,..>]
+//                   [--threads <n>] [--batched]]
+//
+// --check-alloc はウォームアップ後のステップでヒープ確保があれば終了コード3で失敗します
+// --sweep は基準シーンから各軸の全組み合わせのワールドを作って並列に回し、ワールドごとに1行のCSVを出します
+// --batched を付けるとワールドを8個ずつWorldBatchに束ねて回します
+
+namespace {
+	struct RunnerOptions {
+		std::string scenePath;
+		uint32_t chainLinks = 5;
+		uint32_t pileBodies = 0; // 0でなければ鎖の代わりに球を積んだシーンを使う
+		uint32_t steps = 600;
+		uint32_t interval = 60; // 途中経過を出す間隔 (0なら出さない)
+		float gravity = -1.0f; // 負ならシーンの重力のまま
+		std::string statePath;
+		std::string saveScenePath;
+		std::string tracePath; // ENABLE_PROFILER のときだけ有効
+		int64_t allocationWarmup = -1; // 負なら確保を検査しない (ENABLE_ALLOCATION_TRACKING が必要)
+		int64_t reorderInterval = -1; // 負ならシーンの設定のまま
+		std::string broadphase; // 空ならシーンの設定のまま
+		float contactEventThreshold = -1.0f; // 負ならシーンの設定のまま
+		bool sweep = false;
+		bool batched = false; // スイープをWorldBatchで回す
+		SweepAxes sweepAxes;
+		uint32_t threads = 0; // 呼び出し元を含めた並列度 (0ならハードウェアスレッド数)
+	};
+
+	void PrintUsage() {
+		std::fprintf(stderr,
+			"usage: HeadlessRunner [--scene <file> | --chain <links> | --pile <bodies>] [--steps <n>] [--interval <n>]\n"
+			"                      [--gravity <g>] [--state <file>] [--save-scene <file>] [--trace <file>]\n"
+			"                      [--check-alloc <warmup steps>] [--reorder <interval>] [--broadphase <grid|lbvh|verlet>]\n"
+			"                      [--contact-events <min impulse>]\n"
+			"                      [--sweep [--reductions <a,b,..>] [--restitutions <a,b,..>] [--mass-ratios <a,b,..>]\n"
+			"                       [--threads <n>] [--batched]]\n");
+	}
+
+	/// <summary>
+	/// カンマ区切りの数値の並びを読みます
+	/// </summary>
+	bool ParseList(const char* text, std::vector<float>& outValues) {
+		outValues.clear();
+		const char* cursor = text;
+		while (*cursor != '\0') {
+			char* end = nullptr;
+			outValues.push_back(std::strtof(cursor, &end));
+			if (end == cursor || (*end != ',' && *end != '\0')) {
+				return false;
+			}
+			cursor = *end == ',' ? end + 1 : end;
+		}
+		return !outValues.empty();
+	}
+
+	bool ParseOptions(const int argc, char** argv, RunnerOptions& outOptions) {
+		for (int i = 1; i < argc; ++i) {
+			const char* arg = argv[i];
+			const char* value = i + 1 < argc ? argv[i + 1] : nullptr;
+			const auto Next = [&]() {
+				++i;
+				return value;
+			};
+
+			if (std::strcmp(arg, "--help") == 0) {
+				return false;
+			}
+			// 値を取らないオプション
+			if (std::strcmp(arg, "--sweep") == 0) {
+				outOptions.sweep = true;
+				continue;
+			}
+			if (std::strcmp(arg, "--batched") == 0) {
+				outOptions.batched = true;
+				continue;
+			}
+			if (value == nullptr) {
+				std::fprintf(stderr, "missing value for %s\n", arg);
+				return false;
+			}
+
+			if (std::strcmp(arg, "--scene") == 0) {
+				outOptions.scenePath = Next();
+			} else if (std::strcmp(arg, "--chain") == 0) {
+				outOptions.chainLinks = static_cast<uint32_t>(std::strtoul(Next(), nullptr, 10));
+			} else if (std::strcmp(arg, "--pile") == 0) {
+				outOptions.pileBodies = static_cast<uint32_t>(std::strtoul(Next(), nullptr, 10));
+			} else if (std::strcmp(arg, "--steps") == 0) {
+				outOptions.steps = static_cast<uint32_t>(std::strtoul(Next(), nullptr, 10));
+			} else if (std::strcmp(arg, "--interval") == 0) {
+				outOptions.interval = static_cast<uint32_t>(std::strtoul(Next(), nullptr, 10));
+			} else if (std::strcmp(arg, "--gravity") == 0) {
+				outOptions.gravity = std::strtof(Next(), nullptr);
+			} else if (std::strcmp(arg, "--state") == 0) {
+				outOptions.statePath = Next();
+			} else if (std::strcmp(arg, "--save-scene") == 0) {
+				outOptions.saveScenePath = Next();
+			} else if (std::strcmp(arg, "--trace") == 0) {
+				outOptions.tracePath = Next();
+			} else if (std::strcmp(arg, "--check-alloc") == 0) {
+				outOptions.allocationWarmup = std::strtoll(Next(), nullptr, 10);
+			} else if (std::strcmp(arg, "--reorder") == 0) {
+				outOptions.reorderInterval = std::strtoll(Next(), nullptr, 10);
+			} else if (std::strcmp(arg, "--broadphase") == 0) {
+				outOptions.broadphase = Next();
+			} else if (std::strcmp(arg, "--contact-events") == 0) {
+				outOptions.contactEventThreshold = std::strtof(Next(), nullptr);
+			} else if (std::strcmp(arg, "--reductions") == 0) {
+				if (!ParseList(Next(), outOptions.sweepAxes.reductionFactors)) {
+					std::fprintf(stderr, "invalid list for %s\n", arg);
+					return false;
+				}
+			} else if (std::strcmp(arg, "--restitutions") == 0) {
+				if (!ParseList(Next(), outOptions.sweepAxes.restitutions)) {
+					std::fprintf(stderr, "invalid list for %s\n", arg);
+					return false;
+				}
+			} else if (std::strcmp(arg, "--mass-ratios") == 0) {
+				if (!ParseList(Next(), outOptions.sweepAxes.massRatios)) {
+					std::fprintf(stderr, "invalid list for %s\n", arg);
+					return false;
+				}
+			} else if (std::strcmp(arg, "--threads") == 0) {
+				outOptions.threads = static_cast<uint32_t>(std::strtoul(Next(), nullptr, 10));
+			} else {
+				std::fprintf(stderr, "unknown option %s\n", arg);
+				return false;
+			}
+		}
+		return true;
+	}
+
+	/// <summary>
+	/// 最終状態を剛体ごとに1行のCSVで書き出します (並べ替えに関係なくシーンの順)
+	/// </summary>
+	bool WriteState(const std::string& path, const SceneDescription& scene, const PhysicsWorld& world) {
+		FILE* file = std::fopen(path.c_str(), "w");
+		if (file == nullptr) {
+			return false;
+		}
+
+		std::fprintf(file, "name,px,py,pz,vx,vy,vz\n");
+		const BodyArrays& bodies = world.GetBodies();
+		for (uint32_t i = 0; i < bodies.Size(); ++i) {
+			const uint32_t slot = world.GetBodySlot(i);
+			const Vec3& p = bodies.positions[slot];
+			const Vec3& v = bodies.velocities[slot];
+			std::fprintf(file, "%s,%.9g,%.9g,%.9g,%.9g,%.9g,%.9g\n",
+				scene.bodies[i].name.c_str(), p.x, p.y, p.z, v.x, v.y, v.z);
+		}
+
+		return std::fclose(file) == 0;
+	}
+
+	/// <summary>
+	/// 基準シーンから各軸の組み合わせのワールドを作って並列に回し、ワールドごとに1行のCSVを出します
+	/// </summary>
+	int RunSweep(const RunnerOptions& options, const SceneDescription& base) {
+		const std::vector<SceneDescription> scenes = MakeSweepScenes(base, options.sweepAxes);
+		ThreadPool pool(options.threads > 0 ? options.threads - 1 : ThreadPool::kDefaultWorkerCount);
+
+		std::printf("sweep worlds %zu bodies %zu steps %u threads %u batched %d\n", scenes.size(),
+			base.bodies.size(), options.steps, pool.GetConcurrency(), options.batched ? 1 : 0);
+
+		const auto start = std::chrono::steady_clock::now();
+		std::vector<WorldReport> reports;
+		if (options.batched) {
+			RunWorldsBatched(scenes, options.steps, pool, reports);
+		} else {
+			RunWorlds(scenes, options.steps, pool, reports);
+		}
+		const double wallMilliseconds =
+			std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+		// 質量比はシーンから戻せないので、MakeSweepScenesと同じ並び (質量比が一番内側) から求める
+		const std::vector<float>& massRatios = options.sweepAxes.massRatios;
+		std::printf("scene,reductionFactor,restitution,massRatio,initialEnergy,energyDrift,maxPenetration,"
+			"maxResidual,averageIterations,averageStepMs,maxStepMs\n");
+		for (const WorldReport& report : reports) {
+			const SceneDescription& scene = scenes[report.sceneIndex];
+			const float restitution = scene.bodies.empty() ? 0.0f : scene.bodies.front().restitution;
+			const float massRatio = massRatios.empty() ? 1.0f : massRatios[report.sceneIndex % massRatios.size()];
+			std::printf("%u,%g,%g,%g,%.6g,%.6g,%.6g,%.6g,%.3f,%.4f,%.4f\n", report.sceneIndex,
+				scene.settings.reductionFactor, restitution, massRatio, report.initialEnergy, report.energyDrift,
+				report.maxPenetration, report.maxResidual, report.averageIterations, report.averageStepMilliseconds,
+				report.maxStepMilliseconds);
+		}
+
+		std::printf("\nsummary\n");
+		std::printf("wall_ms %.4f\n", wallMilliseconds);
+		std::printf("worlds_per_second %.3f\n", static_cast<double>(scenes.size()) * 1000.0 / wallMilliseconds);
+		return 0;
+	}
+}
+
+int main(int argc, char** argv) {
+	RunnerOptions options;
+	if (!ParseOptions(argc, argv, options)) {
+		PrintUsage();
+		return 2;
+	}
+
+	SceneDescription scene;
+	if (options.scenePath.empty()) {
+		scene = options.pileBodies > 0 ? SceneDescription::MakePile(options.pileBodies)
+			: SceneDescription::MakeChain(options.chainLinks);
+	} else {
+		std::string error;
+		if (!SceneDescription::LoadFromFile(options.scenePath, scene, error)) {
+			std::fprintf(stderr, "%s\n", error.c_str());
+			return 1;
+		}
+	}
+	if (options.gravity >= 0.0f) {
+		scene.gravity = {0.0f, -options.gravity, 0.0f};
+	}
+	if (options.reorderInterval >= 0) {
+		scene.settings.reorderInterval = static_cast<uint32_t>(options.reorderInterval);
+	}
+	if (!options.broadphase.empty()) {
+		const auto name = std::find(std::begin(kBroadphaseNames), std::end(kBroadphaseNames), options.broadphase);
+		if (name == std::end(kBroadphaseNames)) {
+			std::fprintf(stderr, "unknown broadphase %s\n", options.broadphase.c_str());
+			return 2;
+		}
+		scene.settings.broadphase = static_cast<BroadphaseType>(name - std::begin(kBroadphaseNames));
+	}
+	if (options.contactEventThreshold >= 0.0f) {
+		scene.settings.contactEventThreshold = options.contactEventThreshold;
+	}
+
+	if (!options.saveScenePath.empty() && !scene.SaveToFile(options.saveScenePath)) {
+		std::fprintf(stderr, "%s: cannot write\n", options.saveScenePath.c_str());
+		return 1;
+	}
+
+	if (options.sweep) {
+		return RunSweep(options, scene);
+	}
+
+#ifndef ENABLE_ALLOCATION_TRACKING
+	if (options.allocationWarmup >= 0) {
+		std::fprintf(stderr, "--check-alloc requires a build with ENABLE_ALLOCATION_TRACKING\n");
+		return 2;
+	}
+#endif
+
+	PhysicsWorld world;
+	world.Load(scene);
+
+	const float initialEnergy = world.ComputeEnergy();
+	std::vector<double> stepMilliseconds;
+	stepMilliseconds.reserve(options.steps);
+
+	float maxPenetration = 0.0f;
+	float maxResidual = 0.0f;
+	uint64_t totalIterations = 0;
+	uint64_t totalContactEvents = 0;
+	float maxContactImpulse = 0.0f;
+	uint64_t steadyAllocations = 0;
+	uint32_t allocatingSteps = 0;
+
+	std::printf("bodies %u steps %u dt %g\n", world.GetBodies().Size(), options.steps, scene.settings.deltaTime);
+	std::printf("step,ms,iterations,residual,pairs,maxPenetration,energy\n");
+
+	for (uint32_t step = 1; step <= options.steps; ++step) {
+		PROFILE_FRAME();
+		const AllocationCounters before = GetThreadAllocations();
+		world.Step();
+		const AllocationCounters after = GetThreadAllocations();
+
+		// ウォームアップが終わった後のステップはヒープを使ってはいけない
+		if (options.allocationWarmup >= 0 && step > options.allocationWarmup && after.count != before.count) {
+			steadyAllocations += after.count - before.count;
+			++allocatingSteps;
+		}
+
+		const StepMetrics& metrics = world.GetMetrics();
+		stepMilliseconds.push_back(metrics.stepMilliseconds);
+		maxPenetration = std::max(maxPenetration, metrics.maxPenetration);
+		maxResidual = std::max(maxResidual, metrics.solver.residual);
+		totalIterations += metrics.solver.iterations;
+		for (const ContactEvent& event : world.GetContactEvents()) {
+			maxContactImpulse = std::max(maxContactImpulse, event.impulse);
+		}
+		totalContactEvents += world.GetContactEvents().size();
+
+		if (options.interval > 0 && step % options.interval == 0) {
+			std::printf("%u,%.4f,%u,%.6g,%u,%.6g,%.6g\n", step, metrics.stepMilliseconds, metrics.solver.iterations,
+				metrics.solver.residual, metrics.pairCount, metrics.maxPenetration,
+				metrics.kineticEnergy + metrics.potentialEnergy);
+		}
+	}
+
+	// ステップ時間の分布
+	if (!stepMilliseconds.empty()) {
+		std::vector<double> sorted = stepMilliseconds;
+		std::sort(sorted.begin(), sorted.end());
+		const auto Percentile = [&](const double p) {
+			const size_t index = static_cast<size_t>(p * static_cast<double>(sorted.size() - 1));
+			return sorted[index];
+		};
+
+		double total = 0.0;
+		for (const double ms : sorted) {
+			total += ms;
+		}
+
+		const float finalEnergy = world.ComputeEnergy();
+		std::printf("\nsummary\n");
+		std::printf("total_ms %.4f\n", total);
+		std::printf("mean_ms %.4f\n", total / static_cast<double>(sorted.size()));
+		std::printf("p50_ms %.4f\n", Percentile(0.5));
+		std::printf("p99_ms %.4f\n", Percentile(0.99));
+		std::printf("max_ms %.4f\n", sorted.back());
+		std::printf("mean_iterations %.3f\n", static_cast<double>(totalIterations) / static_cast<double>(sorted.size()));
+		std::printf("max_residual %.6g\n", maxResidual);
+		std::printf("max_penetration %.6g\n", maxPenetration);
+		std::printf("energy_initial %.6g\n", initialEnergy);
+		std::printf("energy_final %.6g\n", finalEnergy);
+		if (scene.settings.contactEventThreshold >= 0.0f) {
+			std::printf("contact_events %llu\n", static_cast<unsigned long long>(totalContactEvents));
+			std::printf("max_contact_impulse %.6g\n", maxContactImpulse);
+		}
+	}
+
+	if (!options.statePath.empty() && !WriteState(options.statePath, scene, world)) {
+		std::fprintf(stderr, "%s: cannot write\n", options.statePath.c_str());
+		return 1;
+	}
+
+	if (options.allocationWarmup >= 0) {
+		std::printf("steady_allocations %llu\n", static_cast<unsigned long long>(steadyAllocations));
+		if (allocatingSteps > 0) {
+			std::fprintf(stderr, "%u steps after warm-up allocated %llu times\n", allocatingSteps,
+				static_cast<unsigned long long>(steadyAllocations));
+			return 3;
+		}
+	}
+
+#ifdef ENABLE_PROFILER
+	if (!options.tracePath.empty() && !Profiler::GetInstance()->ExportChromeTrace(options.tracePath)) {
+		std::fprintf(stderr, "%s: cannot write\n", options.tracePath.c_str());
+		return 1;
+	}
+#endif
+
+	return 0;
+}
@@ -0,0 +1,244 @@
+#include "LinearBvh.h"
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cassert>
+
+#include "CollisionFilter.h"
+#include "Profiler.h"
+#include "ThreadPool.h"
+
+namespace {
+	// これより少ない剛体数ではスレッドに分けない
+	constexpr uint32_t kParallelThreshold = 4096;
+	constexpr uint32_t kGrainSize = 1024;
+	// ペア探索の範囲の数 (並列度あたり)
+	constexpr uint32_t kChunksPerThread = 4;
+	// 共通ビットは1段ごとに増え、コード30bit + 添字32bitを超えないので木の深さもこれ以下
+	constexpr uint32_t kMaxDepth = 64;
+
+	/// <summary>
+	/// poolがあれば [0, count) をスレッドへ分け、なければその場で実行します
+	/// </summary>
+	template <typename Func>
+	void ForEachRange(ThreadPool* pool, const uint32_t count, const uint32_t grainSize, const Func& func) {
+		if (pool != nullptr) {
+			pool->ParallelFor(count, grainSize, func);
+		} else {
+			func(0, count);
+		}
+	}
+}
+
+void LinearBvh::Build(const std::span<const Vec3> positions, const std::span<const float> radii, ThreadPool* pool) {
+	PROFILE_ZONE("LinearBvh::Build");
+
+	const uint32_t count = static_cast<uint32_t>(positions.size());
+	if (count < kParallelThreshold) {
+		pool = nullptr;
+	}
+
+	sort_.Sort(positions, pool);
+	const std::span<const uint32_t> order = sort_.GetOrder();
+
+	leafBodies_.assign(order.begin(), order.end());
+	leafPositions_.resize(count);
+	leafRadii_.resize(count);
+	leafBounds_.resize(count);
+	leafParents_.resize(count);
+	nodes_.resize(count > 0 ? count - 1 : 0);
+	nodeParents_.resize(nodes_.size());
+	visits_.assign(nodes_.size(), 0);
+	if (count == 0) {
+		return;
+	}
+
+	// 葉をモートン順に詰め直す
+	ForEachRange(pool, count, kGrainSize, [&](const uint32_t begin, const uint32_t end) {
+		for (uint32_t i = begin; i < end; ++i) {
+			const uint32_t body = order[i];
+			const Vec3& position = positions[body];
+			const float radius = radii[body];
+			leafPositions_[i] = position;
+			leafRadii_[i] = radius;
+			leafBounds_[i] = {position - radius, position + radius};
+		}
+	});
+
+	const uint32_t nodeCount = GetNodeCount();
+	ForEachRange(pool, nodeCount, kGrainSize, [&](const uint32_t begin, const uint32_t end) {
+		for (uint32_t i = begin; i < end; ++i) {
+			BuildNode(i);
+		}
+	});
+
+	ForEachRange(pool, count, kGrainSize, [&](const uint32_t begin, const uint32_t end) {
+		for (uint32_t i = begin; i < end; ++i) {
+			PropagateBounds(i);
+		}
+	});
+}
+
+void LinearBvh::FindPairs(std::vector<BodyPair>& outPairs, const CollisionFilter* filter, ThreadPool* pool) {
+	PROFILE_ZONE("LinearBvh::FindPairs");
+	outPairs.clear();
+
+	const uint32_t count = GetBodyCount();
+	if (pool == nullptr || count < kParallelThreshold) {
+		CollectPairs(0, count, filter, outPairs);
+		return;
+	}
+
+	// 範囲ごとに別の配列へ書き、範囲の順につなげるのでスレッド数によらず同じ並びになる
+	const uint32_t chunkCount = pool->GetConcurrency() * kChunksPerThread;
+	const uint32_t chunkSize = (count + chunkCount - 1) / chunkCount;
+	if (chunkPairs_.size() < chunkCount) {
+		chunkPairs_.resize(chunkCount);
+	}
+	pool->ParallelFor(chunkCount, 1, [&](const uint32_t begin, const uint32_t end) {
+		for (uint32_t chunk = begin; chunk < end; ++chunk) {
+			chunkPairs_[chunk].clear();
+			CollectPairs(std::min(count, chunk * chunkSize), std::min(count, (chunk + 1) * chunkSize), filter,
+				chunkPairs_[chunk]);
+		}
+	});
+
+	for (uint32_t chunk = 0; chunk < chunkCount; ++chunk) {
+		outPairs.insert(outPairs.end(), chunkPairs_[chunk].begin(), chunkPairs_[chunk].end());
+	}
+}
+
+int32_t LinearBvh::CommonPrefix(const int32_t i, const int32_t j) const {
+	if (j < 0 || j >= static_cast<int32_t>(GetBodyCount())) {
+		return -1;
+	}
+
+	const std::span<const uint32_t> codes = sort_.GetCodes();
+	const uint32_t codeA = codes[i];
+	const uint32_t codeB = codes[j];
+	if (codeA == codeB) {
+		return 32 + std::countl_zero(static_cast<uint32_t>(i ^ j));
+	}
+	return std::countl_zero(codeA ^ codeB);
+}
+
+void LinearBvh::BuildNode(const uint32_t index) {
+	const int32_t i = static_cast<int32_t>(index);
+
+	// 共通ビットが長い側に範囲が伸びる
+	const int32_t direction = CommonPrefix(i, i + 1) - CommonPrefix(i, i - 1) >= 0 ? 1 : -1;
+	const int32_t minPrefix = CommonPrefix(i, i - direction);
+
+	// 範囲のもう一方の端を倍々で見つけてから二分探索する
+	int32_t maxLength = 2;
+	while (CommonPrefix(i, i + maxLength * direction) > minPrefix) {
+		maxLength *= 2;
+	}
+	int32_t length = 0;
+	for (int32_t step = maxLength / 2; step >= 1; step /= 2) {
+		if (CommonPrefix(i, i + (length + step) * direction) > minPrefix) {
+			length += step;
+		}
+	}
+	const int32_t j = i + length * direction;
+
+	// 範囲の中で共通ビットが変わる位置で分割する
+	const int32_t nodePrefix = CommonPrefix(i, j);
+	int32_t split = 0;
+	int32_t step = length;
+	do {
+		step = (step + 1) / 2;
+		if (CommonPrefix(i, i + (split + step) * direction) > nodePrefix) {
+			split += step;
+		}
+	} while (step > 1);
+	const uint32_t gamma = static_cast<uint32_t>(i + split * direction + std::min(direction, 0));
+
+	// 範囲の端と分割位置が一致した側は葉
+	const uint32_t first = static_cast<uint32_t>(std::min(i, j));
+	const uint32_t last = static_cast<uint32_t>(std::max(i, j));
+	Node& node = nodes_[index];
+	node.left = first == gamma ? gamma | kLeafBit : gamma;
+	node.right = last == gamma + 1 ? (gamma + 1) | kLeafBit : gamma + 1;
+	node.last = last;
+
+	if (node.left & kLeafBit) {
+		leafParents_[gamma] = index;
+	} else {
+		nodeParents_[gamma] = index;
+	}
+	if (node.right & kLeafBit) {
+		leafParents_[gamma + 1] = index;
+	} else {
+		nodeParents_[gamma + 1] = index;
+	}
+}
+
+void LinearBvh::PropagateBounds(const uint32_t leaf) {
+	if (nodes_.empty()) {
+		return;
+	}
+
+	uint32_t index = leafParents_[leaf];
+	while (true) {
+		// 先に着いた子は帰る。後から着いた子は両方の子が確定しているので親を計算できる
+		if (std::atomic_ref(visits_[index]).fetch_add(1, std::memory_order_acq_rel) == 0) {
+			return;
+		}
+
+		Node& node = nodes_[index];
+		const Bounds& left = node.left & kLeafBit ? leafBounds_[node.left & ~kLeafBit] : nodes_[node.left].bounds;
+		const Bounds& right = node.right & kLeafBit ? leafBounds_[node.right & ~kLeafBit] : nodes_[node.right].bounds;
+		node.bounds.minimum = {std::min(left.minimum.x, right.minimum.x), std::min(left.minimum.y, right.minimum.y),
+			std::min(left.minimum.z, right.minimum.z)};
+		node.bounds.maximum = {std::max(left.maximum.x, right.maximum.x), std::max(left.maximum.y, right.maximum.y),
+			std::max(left.maximum.z, right.maximum.z)};
+
+		if (index == 0) {
+			return;
+		}
+		index = nodeParents_[index];
+	}
+}
+
+void LinearBvh::CollectPairs(const uint32_t begin, const uint32_t end, const CollisionFilter* filter,
+	std::vector<BodyPair>& outPairs) const {
+	if (nodes_.empty()) {
+		return;
+	}
+
+	uint32_t stack[kMaxDepth];
+	for (uint32_t i = begin; i < end; ++i) {
+		const Bounds& query = leafBounds_[i];
+		const Vec3& position = leafPositions_[i];
+		const float radius = leafRadii_[i];
+		const uint32_t body = leafBodies_[i];
+
+		uint32_t depth = 0;
+		stack[depth++] = 0;
+		while (depth > 0) {
+			const Node& node = nodes_[stack[--depth]];
+			for (const uint32_t child : {node.left, node.right}) {
+				if (child & kLeafBit) {
+					// 重複を避けるため自分より後ろの葉だけ
+					const uint32_t j = child & ~kLeafBit;
+					if (j <= i) {
+						continue;
+					}
+					const uint32_t other = leafBodies_[j];
+					if (filter != nullptr && !filter->ShouldCollide(body, other)) {
+						continue;
+					}
+					const float radiusSum = radius + leafRadii_[j];
+					if ((leafPositions_[j] - position).SqrtLength() < radiusSum * radiusSum) {
+						outPairs.push_back({std::min(body, other), std::max(body, other)});
+					}
+				} else if (nodes_[child].last > i && nodes_[child].bounds.Overlaps(query)) {
+					assert(depth < kMaxDepth && "LinearBvh is deeper than expected");
+					stack[depth++] = child;
+				}
+			}
+		}
+	}
+}
@@ -0,0 +1,107 @@
+#pragma once
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include "MortonSort.h"
+#include "SpatialGrid.h"
+#include "Vec3.h"
+
+class ThreadPool;
+struct CollisionFilter;
+
+/// <summary>
+/// モートンコード順に並べた球から毎フレーム作り直す線形BVH (LBVH)
+/// 内部ノードは互いに独立に作れる (Karras 2012) ので、構築全体がO(n)で並列に進みます
+/// 木を更新せずに作り直すので、全部の剛体が動き回るシーンでも質が落ちません
+/// </summary>
+class LinearBvh {
+public:
+	/// <summary>
+	/// 木を作り直します
+	/// </summary>
+	/// <param name="positions">剛体の中心座標</param>
+	/// <param name="radii">剛体の半径</param>
+	/// <param name="pool">渡すとソート・ノードの作成・AABBの計算をスレッドへ分けます</param>
+	void Build(std::span<const Vec3> positions, std::span<const float> radii, ThreadPool* pool = nullptr);
+
+	/// <summary>
+	/// 球同士が重なっているペアを列挙します (SpatialGrid::FindPairsと同じ条件)
+	/// poolを渡すと葉の範囲ごとにスレッドへ分け、範囲の順につなげます
+	/// </summary>
+	/// <param name="filter">渡すと衝突させない組を距離を測る前に除きます</param>
+	void FindPairs(std::vector<BodyPair>& outPairs, const CollisionFilter* filter = nullptr,
+		ThreadPool* pool = nullptr);
+
+	uint32_t GetBodyCount() const {
+		return static_cast<uint32_t>(leafBodies_.size());
+	}
+
+	/// <summary>
+	/// 内部ノードの数 (剛体数 - 1)
+	/// </summary>
+	uint32_t GetNodeCount() const {
+		return static_cast<uint32_t>(nodes_.size());
+	}
+
+private:
+	// 子の番号のこのビットが立っていれば葉
+	static constexpr uint32_t kLeafBit = 0x80000000u;
+
+	struct Bounds {
+		Vec3 minimum;
+		Vec3 maximum;
+
+		bool Overlaps(const Bounds& other) const {
+			return minimum.x <= other.maximum.x && other.minimum.x <= maximum.x &&
+				minimum.y <= other.maximum.y && other.minimum.y <= maximum.y &&
+				minimum.z <= other.maximum.z && other.minimum.z <= maximum.z;
+		}
+	};
+
+	struct Node {
+		Bounds bounds;
+		uint32_t left;
+		uint32_t right;
+		uint32_t last; // 部分木に含まれる最後の葉
+	};
+
+	/// <summary>
+	/// ソート済みのi番目とj番目のコードの共通の上位ビット数 (範囲外なら-1)
+	/// 同じコードのときは添字の共通ビットを足して区別します
+	/// </summary>
+	int32_t CommonPrefix(int32_t i, int32_t j) const;
+
+	/// <summary>
+	/// i番目の内部ノードが覆う葉の範囲を求め、分割位置で子をつなぎます
+	/// </summary>
+	void BuildNode(uint32_t index);
+
+	/// <summary>
+	/// 葉からルートへ上り、2番目に着いた子が親のAABBを計算します
+	/// </summary>
+	void PropagateBounds(uint32_t leaf);
+
+	/// <summary>
+	/// 葉 [begin, end) について、自分より後ろの葉と重なるペアを書き出します
+	/// </summary>
+	void CollectPairs(uint32_t begin, uint32_t end, const CollisionFilter* filter, std::vector<BodyPair>& outPairs) const;
+
+	MortonSort sort_;
+
+	// ここから下の葉はモートン順
+	std::vector<uint32_t> leafBodies_;
+	std::vector<Vec3> leafPositions_;
+	std::vector<float> leafRadii_;
+	std::vector<Bounds> leafBounds_;
+	std::vector<uint32_t> leafParents_;
+
+	// 内部ノード (0がルート)
+	std::vector<Node> nodes_;
+	std::vector<uint32_t> nodeParents_;
+	// AABBの計算で子が何個着いたか (std::atomic_refで数える)
+	std::vector<uint32_t> visits_;
+
+	// 並列にペアを探すときの範囲ごとの出力
+	std::vector<std::vector<BodyPair>> chunkPairs_;
+};
@@ -1,160 +1,195 @@
 #include "Mat4.h"
 
+#include <algorithm>
 #include <cassert>
 #include <cmath>
-#include <format>
+#include <type_traits>
+
+#include "ThreadPool.h"
+#include "Vec3Packet.h"
+
+// x86ではSSEで行列の積・転置・逆行列を計算する
+#if defined(_M_X64) || defined(_M_IX86) || defined(__SSE2__)
+#define MAT4_SIMD
+#include <xmmintrin.h>
+#endif
+
+#ifdef MAT4_SIMD
+namespace {
+	// 2x2行列 (x y / z w) を1レジスタに詰めて扱う
+	// 参考: 2x2のブロックに分けて余因子を求める方法
+	template <int X, int Y, int Z, int W>
+	__m128 Shuffle(const __m128 a, const __m128 b) {
+		return _mm_shuffle_ps(a, b, _MM_SHUFFLE(W, Z, Y, X));
+	}
+
+	template <int X, int Y, int Z, int W>
+	__m128 Swizzle(const __m128 v) {
+		return Shuffle<X, Y, Z, W>(v, v);
+	}
 
-#include "Camera.h"
+	// a * b
+	__m128 Mat2Mul(const __m128 a, const __m128 b) {
+		return _mm_add_ps(_mm_mul_ps(a, Swizzle<0, 3, 0, 3>(b)),
+			_mm_mul_ps(Swizzle<1, 0, 3, 2>(a), Swizzle<2, 1, 2, 1>(b)));
+	}
 
-Mat4 Mat4::operator+(const Mat4& rhs) const {
+	// adj(a) * b
+	__m128 Mat2AdjMul(const __m128 a, const __m128 b) {
+		return _mm_sub_ps(_mm_mul_ps(Swizzle<3, 3, 0, 0>(a), b),
+			_mm_mul_ps(Swizzle<1, 1, 2, 2>(a), Swizzle<2, 3, 0, 1>(b)));
+	}
+
+	// a * adj(b)
+	__m128 Mat2MulAdj(const __m128 a, const __m128 b) {
+		return _mm_sub_ps(_mm_mul_ps(a, Swizzle<3, 0, 3, 0>(b)),
+			_mm_mul_ps(Swizzle<1, 0, 3, 2>(a), Swizzle<2, 1, 2, 1>(b)));
+	}
+}
+
+Mat4 Mat4::operator*(const Mat4& rhs) const {
+	const __m128 b0 = _mm_loadu_ps(rhs.m[0]);
+	const __m128 b1 = _mm_loadu_ps(rhs.m[1]);
+	const __m128 b2 = _mm_loadu_ps(rhs.m[2]);
+	const __m128 b3 = _mm_loadu_ps(rhs.m[3]);
+
+	// 結果のi行目 = Σk m[i][k] * rhsのk行目
 	Mat4 result;
-	for (int i = 0; i < 4; ++i)
-		for (int j = 0; j < 4; ++j)
-			result.m[i][j] = m[i][j] + rhs.m[i][j];
+	for (int i = 0; i < 4; ++i) {
+		__m128 row = _mm_mul_ps(_mm_set1_ps(m[i][0]), b0);
+		row = _mm_add_ps(row, _mm_mul_ps(_mm_set1_ps(m[i][1]), b1));
+		row = _mm_add_ps(row, _mm_mul_ps(_mm_set1_ps(m[i][2]), b2));
+		row = _mm_add_ps(row, _mm_mul_ps(_mm_set1_ps(m[i][3]), b3));
+		_mm_storeu_ps(result.m[i], row);
+	}
 	return result;
 }
 
-Mat4 Mat4::operator-(const Mat4& rhs) const {
-	return {
-		{
-			{m[0][0] - rhs.m[0][0], m[0][1] - rhs.m[0][1], m[0][2] - rhs.m[0][2], m[0][3] - rhs.m[0][3]},
-			{m[1][0] - rhs.m[1][0], m[1][1] - rhs.m[1][1], m[1][2] - rhs.m[1][2], m[1][3] - rhs.m[1][3]},
-			{m[2][0] - rhs.m[2][0], m[2][1] - rhs.m[2][1], m[2][2] - rhs.m[2][2], m[2][3] - rhs.m[2][3]},
-			{m[3][0] - rhs.m[3][0], m[3][1] - rhs.m[3][1], m[3][2] - rhs.m[3][2], m[3][3] - rhs.m[3][3]},
-		},
-	};
+Mat4 Mat4::Inverse() const {
+	const __m128 r0 = _mm_loadu_ps(m[0]);
+	const __m128 r1 = _mm_loadu_ps(m[1]);
+	const __m128 r2 = _mm_loadu_ps(m[2]);
+	const __m128 r3 = _mm_loadu_ps(m[3]);
+
+	// | A B |
+	// | C D | の2x2ブロックに分ける
+	const __m128 a = _mm_movelh_ps(r0, r1);
+	const __m128 b = _mm_movehl_ps(r1, r0);
+	const __m128 c = _mm_movelh_ps(r2, r3);
+	const __m128 d = _mm_movehl_ps(r3, r2);
+
+	// 各ブロックの行列式 (detA, detB, detC, detD)
+	const __m128 detSub = _mm_sub_ps(
+		_mm_mul_ps(Shuffle<0, 2, 0, 2>(r0, r2), Shuffle<1, 3, 1, 3>(r1, r3)),
+		_mm_mul_ps(Shuffle<1, 3, 1, 3>(r0, r2), Shuffle<0, 2, 0, 2>(r1, r3)));
+	const __m128 detA = Swizzle<0, 0, 0, 0>(detSub);
+	const __m128 detB = Swizzle<1, 1, 1, 1>(detSub);
+	const __m128 detC = Swizzle<2, 2, 2, 2>(detSub);
+	const __m128 detD = Swizzle<3, 3, 3, 3>(detSub);
+
+	const __m128 dc = Mat2AdjMul(d, c);
+	const __m128 ab = Mat2AdjMul(a, b);
+
+	__m128 x = _mm_sub_ps(_mm_mul_ps(detD, a), Mat2Mul(b, dc));
+	__m128 w = _mm_sub_ps(_mm_mul_ps(detA, d), Mat2Mul(c, ab));
+	__m128 y = _mm_sub_ps(_mm_mul_ps(detB, c), Mat2MulAdj(d, ab));
+	__m128 z = _mm_sub_ps(_mm_mul_ps(detC, b), Mat2MulAdj(a, dc));
+
+	// det = detA * detD + detB * detC - tr(adj(A)B * adj(D)C)
+	__m128 trace = _mm_mul_ps(ab, Swizzle<0, 2, 1, 3>(dc));
+	trace = _mm_add_ps(trace, Swizzle<2, 3, 0, 1>(trace));
+	trace = _mm_add_ps(trace, Swizzle<1, 0, 3, 2>(trace));
+	const __m128 det = _mm_sub_ps(_mm_add_ps(_mm_mul_ps(detA, detD), _mm_mul_ps(detB, detC)), trace);
+
+	assert(_mm_cvtss_f32(det) != 0.0f && "Matrix is not invertible");
+
+	const __m128 invDet = _mm_div_ps(_mm_setr_ps(1.0f, -1.0f, -1.0f, 1.0f), det);
+	x = _mm_mul_ps(x, invDet);
+	y = _mm_mul_ps(y, invDet);
+	z = _mm_mul_ps(z, invDet);
+	w = _mm_mul_ps(w, invDet);
+
+	Mat4 result;
+	_mm_storeu_ps(result.m[0], Shuffle<3, 1, 3, 1>(x, y));
+	_mm_storeu_ps(result.m[1], Shuffle<2, 0, 2, 0>(x, y));
+	_mm_storeu_ps(result.m[2], Shuffle<3, 1, 3, 1>(z, w));
+	_mm_storeu_ps(result.m[3], Shuffle<2, 0, 2, 0>(z, w));
+	return result;
 }
 
+Mat4 Mat4::Transpose() const {
+	__m128 r0 = _mm_loadu_ps(m[0]);
+	__m128 r1 = _mm_loadu_ps(m[1]);
+	__m128 r2 = _mm_loadu_ps(m[2]);
+	__m128 r3 = _mm_loadu_ps(m[3]);
+	_MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+
+	Mat4 result;
+	_mm_storeu_ps(result.m[0], r0);
+	_mm_storeu_ps(result.m[1], r1);
+	_mm_storeu_ps(result.m[2], r2);
+	_mm_storeu_ps(result.m[3], r3);
+	return result;
+}
+#else
 Mat4 Mat4::operator*(const Mat4& rhs) const {
-	return {
-		{
-			{
-				m[0][0] * rhs.m[0][0] + m[0][1] * rhs.m[1][0] + m[0][2] * rhs.m[2][0] + m[0][3] * rhs.m[3][0],
-				m[0][0] * rhs.m[0][1] + m[0][1] * rhs.m[1][1] + m[0][2] * rhs.m[2][1] + m[0][3] * rhs.m[3][1],
-				m[0][0] * rhs.m[0][2] + m[0][1] * rhs.m[1][2] + m[0][2] * rhs.m[2][2] + m[0][3] * rhs.m[3][2],
-				m[0][0] * rhs.m[0][3] + m[0][1] * rhs.m[1][3] + m[0][2] * rhs.m[2][3] + m[0][3] * rhs.m[3][3]
-			},
-			{
-				m[1][0] * rhs.m[0][0] + m[1][1] * rhs.m[1][0] + m[1][2] * rhs.m[2][0] + m[1][3] * rhs.m[3][0],
-				m[1][0] * rhs.m[0][1] + m[1][1] * rhs.m[1][1] + m[1][2] * rhs.m[2][1] + m[1][3] * rhs.m[3][1],
-				m[1][0] * rhs.m[0][2] + m[1][1] * rhs.m[1][2] + m[1][2] * rhs.m[2][2] + m[1][3] * rhs.m[3][2],
-				m[1][0] * rhs.m[0][3] + m[1][1] * rhs.m[1][3] + m[1][2] * rhs.m[2][3] + m[1][3] * rhs.m[3][3]
-			},
-			{
-				m[2][0] * rhs.m[0][0] + m[2][1] * rhs.m[1][0] + m[2][2] * rhs.m[2][0] + m[2][3] * rhs.m[3][0],
-				m[2][0] * rhs.m[0][1] + m[2][1] * rhs.m[1][1] + m[2][2] * rhs.m[2][1] + m[2][3] * rhs.m[3][1],
-				m[2][0] * rhs.m[0][2] + m[2][1] * rhs.m[1][2] + m[2][2] * rhs.m[2][2] + m[2][3] * rhs.m[3][2],
-				m[2][0] * rhs.m[0][3] + m[2][1] * rhs.m[1][3] + m[2][2] * rhs.m[2][3] + m[2][3] * rhs.m[3][3]
-			},
-			{
-				m[3][0] * rhs.m[0][0] + m[3][1] * rhs.m[1][0] + m[3][2] * rhs.m[2][0] + m[3][3] * rhs.m[3][0],
-				m[3][0] * rhs.m[0][1] + m[3][1] * rhs.m[1][1] + m[3][2] * rhs.m[2][1] + m[3][3] * rhs.m[3][1],
-				m[3][0] * rhs.m[0][2] + m[3][1] * rhs.m[1][2] + m[3][2] * rhs.m[2][2] + m[3][3] * rhs.m[3][2],
-				m[3][0] * rhs.m[0][3] + m[3][1] * rhs.m[1][3] + m[3][2] * rhs.m[2][3] + m[3][3] * rhs.m[3][3]
-			}
-		},
-	};
+	Mat4 result;
+	for (int i = 0; i < 4; ++i) {
+		for (int j = 0; j < 4; ++j) {
+			result.m[i][j] = m[i][0] * rhs.m[0][j] + m[i][1] * rhs.m[1][j] + m[i][2] * rhs.m[2][j] + m[i][3] * rhs.m[3][j];
+		}
+	}
+	return result;
 }
 
 Mat4 Mat4::Inverse() const {
-	const float a =
-		m[0][0] * m[1][1] * m[2][2] * m[3][3] + m[0][0] * m[1][2] * m[2][3] * m[3][1] + m[0][0] * m[1][3] * m[2][1]
-		* m[3][2] -
-		m[0][0] * m[1][3] * m[2][2] * m[3][1] - m[0][0] * m[1][2] * m[2][1] * m[3][3] - m[0][0] * m[1][1] * m[2][3]
-		* m[3][2] -
-		m[0][1] * m[1][0] * m[2][2] * m[3][3] - m[0][2] * m[1][0] * m[2][3] * m[3][1] - m[0][3] * m[1][0] * m[2][1]
-		* m[3][2] +
-		m[0][3] * m[1][0] * m[2][2] * m[3][1] + m[0][2] * m[1][0] * m[2][1] * m[3][3] + m[0][1] * m[1][0] * m[2][3]
-		* m[3][2] +
-		m[0][1] * m[1][2] * m[2][0] * m[3][3] + m[0][2] * m[1][3] * m[2][0] * m[3][1] + m[0][3] * m[1][1] * m[2][0]
-		* m[3][2] -
-		m[0][3] * m[1][2] * m[2][0] * m[3][1] - m[0][2] * m[1][1] * m[2][0] * m[3][3] - m[0][1] * m[1][3] * m[2][0]
-		* m[3][2] -
-		m[0][1] * m[1][2] * m[2][3] * m[3][0] - m[0][2] * m[1][3] * m[2][1] * m[3][0] - m[0][3] * m[1][1] * m[2][2]
-		* m[3][0] +
-		m[0][3] * m[1][2] * m[2][1] * m[3][0] + m[0][2] * m[1][1] * m[2][3] * m[3][0] + m[0][1] * m[1][3] * m[2][2]
-		* m[3][0];
-
-	const Mat4 result = {
+	// 上2行と下2行の2x2小行列式から余因子を組み立てる
+	const float s0 = m[0][0] * m[1][1] - m[1][0] * m[0][1];
+	const float s1 = m[0][0] * m[1][2] - m[1][0] * m[0][2];
+	const float s2 = m[0][0] * m[1][3] - m[1][0] * m[0][3];
+	const float s3 = m[0][1] * m[1][2] - m[1][1] * m[0][2];
+	const float s4 = m[0][1] * m[1][3] - m[1][1] * m[0][3];
+	const float s5 = m[0][2] * m[1][3] - m[1][2] * m[0][3];
+
+	const float c5 = m[2][2] * m[3][3] - m[3][2] * m[2][3];
+	const float c4 = m[2][1] * m[3][3] - m[3][1] * m[2][3];
+	const float c3 = m[2][1] * m[3][2] - m[3][1] * m[2][2];
+	const float c2 = m[2][0] * m[3][3] - m[3][0] * m[2][3];
+	const float c1 = m[2][0] * m[3][2] - m[3][0] * m[2][2];
+	const float c0 = m[2][0] * m[3][1] - m[3][0] * m[2][1];
+
+	const float det = s0 * c5 - s1 * c4 + s2 * c3 + s3 * c2 - s4 * c1 + s5 * c0;
+	assert(det != 0.0f && "Matrix is not invertible");
+	const float invDet = 1.0f / det;
+
+	return {
 		{
 			{
-				(m[1][1] * m[2][2] * m[3][3] + m[1][2] * m[2][3] * m[3][1] + m[1][3] * m[2][1] * m[3][2] - m[1][3] * m[
-						2][2]
-					* m
-					[3][1] - m[1][2] * m[2][1] * m[3][3] - m[1][1] * m[2][3] * m[3][2]) / a,
-				(-m[0][1] * m[2][2] * m[3][3] - m[0][2] * m[2][3] * m[3][1] - m[0][3] * m[2][1] * m[3][2] + m[0][3] * m[
-						2][
-						2] *
-					m[3][1] + m[0][2] * m[2][1] * m[3][3] + m[0][1] * m[2][3] * m[3][2]) / a,
-				(m[0][1] * m[1][2] * m[3][3] + m[0][2] * m[1][3] * m[3][1] + m[0][3] * m[1][1] * m[3][2] - m[0][3] * m[
-						1][2]
-					* m
-					[3][1] - m[0][2] * m[1][1] * m[3][3] - m[0][1] * m[1][3] * m[3][2]) / a,
-				(-m[0][1] * m[1][2] * m[2][3] - m[0][2] * m[1][3] * m[2][1] - m[0][3] * m[1][1] * m[2][2] + m[0][3] * m[
-						1][
-						2] *
-					m[2][1] + m[0][2] * m[1][1] * m[2][3] + m[0][1] * m[1][3] * m[2][2]) / a
+				(m[1][1] * c5 - m[1][2] * c4 + m[1][3] * c3) * invDet,
+				(-m[0][1] * c5 + m[0][2] * c4 - m[0][3] * c3) * invDet,
+				(m[3][1] * s5 - m[3][2] * s4 + m[3][3] * s3) * invDet,
+				(-m[2][1] * s5 + m[2][2] * s4 - m[2][3] * s3) * invDet
 			},
 			{
-				(-m[1][0] * m[2][2] * m[3][3] - m[1][2] * m[2][3] * m[3][0] - m[1][3] * m[2][0] * m[3][2] + m[1][3] * m[
-						2][
-						2] *
-					m[3][0] + m[1][2] * m[2][0] * m[3][3] + m[1][0] * m[2][3] * m[3][2]) / a,
-				(m[0][0] * m[2][2] * m[3][3] + m[0][2] * m[2][3] * m[3][0] + m[0][3] * m[2][0] * m[3][2] - m[0][3] * m[
-						2][2]
-					* m
-					[3][0] - m[0][2] * m[2][0] * m[3][3] - m[0][0] * m[2][3] * m[3][2]) / a,
-				(-m[0][0] * m[1][2] * m[3][3] - m[0][2] * m[1][3] * m[3][0] - m[0][3] * m[1][0] * m[3][2] + m[0][3] * m[
-						1][
-						2] *
-					m[3][0] + m[0][2] * m[1][0] * m[3][3] + m[0][0] * m[1][3] * m[3][2]) / a,
-				(m[0][0] * m[1][2] * m[2][3] + m[0][2] * m[1][3] * m[2][0] + m[0][3] * m[1][0] * m[2][2] - m[0][3] * m[
-						1][2]
-					* m
-					[2][0] - m[0][2] * m[1][0] * m[2][3] - m[0][0] * m[1][3] * m[2][2]) / a
+				(-m[1][0] * c5 + m[1][2] * c2 - m[1][3] * c1) * invDet,
+				(m[0][0] * c5 - m[0][2] * c2 + m[0][3] * c1) * invDet,
+				(-m[3][0] * s5 + m[3][2] * s2 - m[3][3] * s1) * invDet,
+				(m[2][0] * s5 - m[2][2] * s2 + m[2][3] * s1) * invDet
 			},
-
 			{
-				(m[1][0] * m[2][1] * m[3][3] + m[1][1] * m[2][3] * m[3][0] + m[1][3] * m[2][0] * m[3][1] - m[1][3] * m[
-						2][1]
-					* m
-					[3][0] - m[1][1] * m[2][0] * m[3][3] - m[1][0] * m[2][3] * m[3][1]) / a,
-				(-m[0][0] * m[2][1] * m[3][3] - m[0][1] * m[2][3] * m[3][0] - m[0][3] * m[2][0] * m[3][1] + m[0][3] * m[
-						2][
-						1] *
-					m[3][0] + m[0][1] * m[2][0] * m[3][3] + m[0][0] * m[2][3] * m[3][1]) / a,
-				(m[0][0] * m[1][1] * m[3][3] + m[0][1] * m[1][3] * m[3][0] + m[0][3] * m[1][0] * m[3][1] - m[0][3] * m[
-						1][1]
-					* m
-					[3][0] - m[0][1] * m[1][0] * m[3][3] - m[0][0] * m[1][3] * m[3][1]) / a,
-				(-m[0][0] * m[1][1] * m[2][3] - m[0][1] * m[1][3] * m[2][0] - m[0][3] * m[1][0] * m[2][1] + m[0][3] * m[
-						1][
-						1] *
-					m[2][0] * m[0][1] * m[1][0] * m[2][3] + m[0][0] * m[1][3] * m[2][1]) / a
+				(m[1][0] * c4 - m[1][1] * c2 + m[1][3] * c0) * invDet,
+				(-m[0][0] * c4 + m[0][1] * c2 - m[0][3] * c0) * invDet,
+				(m[3][0] * s4 - m[3][1] * s2 + m[3][3] * s0) * invDet,
+				(-m[2][0] * s4 + m[2][1] * s2 - m[2][3] * s0) * invDet
 			},
-
 			{
-				(-m[1][0] * m[2][1] * m[3][2] - m[1][1] * m[2][2] * m[3][0] - m[1][2] * m[2][0] * m[3][1] + m[1][2] * m[
-						2][
-						1] *
-					m[3][0] + m[1][1] * m[2][0] * m[3][2] + m[1][0] * m[2][2] * m[3][1]) / a,
-				(m[0][0] * m[2][1] * m[3][2] + m[0][1] * m[2][2] * m[3][0] + m[0][2] * m[2][0] * m[3][1] - m[0][2] * m[
-						2][1]
-					* m
-					[3][0] - m[0][1] * m[2][0] * m[3][2] - m[0][0] * m[2][2] * m[3][1]) / a,
-				(-m[0][0] * m[1][1] * m[3][2] - m[0][1] * m[1][2] * m[3][0] - m[0][2] * m[1][0] * m[3][1] + m[0][2] * m[
-						1][
-						1] *
-					m[3][0] + m[0][1] * m[1][0] * m[3][2] + m[0][0] * m[1][2] * m[3][1]) / a,
-				(m[0][0] * m[1][1] * m[2][2] + m[0][1] * m[1][2] * m[2][0] + m[0][2] * m[1][0] * m[2][1] - m[0][2] * m[
-						1][1]
-					* m
-					[2][0] - m[0][1] * m[1][0] * m[2][2] - m[0][0] * m[1][2] * m[2][1]) / a
+				(-m[1][0] * c3 + m[1][1] * c1 - m[1][2] * c0) * invDet,
+				(m[0][0] * c3 - m[0][1] * c1 + m[0][2] * c0) * invDet,
+				(-m[3][0] * s3 + m[3][1] * s1 - m[3][2] * s0) * invDet,
+				(m[2][0] * s3 - m[2][1] * s1 + m[2][2] * s0) * invDet
 			}
-		},
+		}
 	};
-
-	return result;
 }
 
 Mat4 Mat4::Transpose() const {
@@ -167,53 +202,54 @@ Mat4 Mat4::Transpose() const {
 		}
 	};
 }
-
-Mat4 Mat4::Identity() {
-	return {
+#endif
+
+Mat4 Mat4::InverseAffine() const {
+	// 行ベクトル形式のアフィン変換 | L 0 |
+	//                               | t 1 | の逆行列は | L^-1 0 | (L^-1は余因子で求める)
+	//                                                  | -tL^-1 1 |
+	const Vec3 r0 = {m[0][0], m[0][1], m[0][2]};
+	const Vec3 r1 = {m[1][0], m[1][1], m[1][2]};
+	const Vec3 r2 = {m[2][0], m[2][1], m[2][2]};
+
+	// L^-1 の各列は他の2行の外積 / det
+	const Vec3 c0 = r1.CrossProduct(r2);
+	const Vec3 c1 = r2.CrossProduct(r0);
+	const Vec3 c2 = r0.CrossProduct(r1);
+	const float det = r0.DotProduct(c0);
+	assert(det != 0.0f && "Matrix is not invertible");
+	const float invDet = 1.0f / det;
+
+	Mat4 result = {
 		{
-			{1.0f, 0.0f, 0.0f, 0.0f},
-			{0.0f, 1.0f, 0.0f, 0.0f},
-			{0.0f, 0.0f, 1.0f, 0.0f},
+			{c0.x * invDet, c1.x * invDet, c2.x * invDet, 0.0f},
+			{c0.y * invDet, c1.y * invDet, c2.y * invDet, 0.0f},
+			{c0.z * invDet, c1.z * invDet, c2.z * invDet, 0.0f},
 			{0.0f, 0.0f, 0.0f, 1.0f}
-		},
+		}
 	};
-}
 
-Mat4 Mat4::Translate(const Vec3& translate) {
-	return {
-		{
-			{1.0f, 0.0f, 0.0f, 0.0f},
-			{0.0f, 1.0f, 0.0f, 0.0f},
-			{0.0f, 0.0f, 1.0f, 0.0f},
-			{translate.x, translate.y, translate.z, 1.0f}
-		},
-	};
+	const Vec3 t = {m[3][0], m[3][1], m[3][2]};
+	for (int j = 0; j < 3; ++j) {
+		result.m[3][j] = -(t.x * result.m[0][j] + t.y * result.m[1][j] + t.z * result.m[2][j]);
+	}
+	return result;
 }
 
-Mat4 Mat4::Scale(const Vec3& scale) {
-	return {
+Mat4 Mat4::InverseRigid() const {
+	// 回転と平行移動だけなら回転部分は転置で逆になる
+	Mat4 result = {
 		{
-			{scale.x, 0.0f, 0.0f, 0.0f},
-			{0.0f, scale.y, 0.0f, 0.0f},
-			{0.0f, 0.0f, scale.z, 0.0f},
+			{m[0][0], m[1][0], m[2][0], 0.0f},
+			{m[0][1], m[1][1], m[2][1], 0.0f},
+			{m[0][2], m[1][2], m[2][2], 0.0f},
 			{0.0f, 0.0f, 0.0f, 1.0f}
-		},
+		}
 	};
-}
 
-Vec3 Mat4::Transform(const Vec3& vector, const Mat4& matrix) {
-	Vec3 result; // w=1がデカルト座標系であるので(x,y,z,1)のベクトルとしてmatrixとの積をとる
-	result.x = vector.x * matrix.m[0][0] + vector.y * matrix.m[1][0] + vector.z * matrix.m[2][0] + 1.0f * matrix.m[3][
-		0];
-	result.y = vector.x * matrix.m[0][1] + vector.y * matrix.m[1][1] + vector.z * matrix.m[2][1] + 1.0f * matrix.m[3][
-		1];
-	result.z = vector.x * matrix.m[0][2] + vector.y * matrix.m[1][2] + vector.z * matrix.m[2][2] + 1.0f * matrix.m[3][
-		2];
-	float w = vector.x * matrix.m[0][3] + vector.y * matrix.m[1][3] + vector.z * matrix.m[2][3] + 1.0f * matrix.m[3][3];
-	assert(w != 0.0f); // ベクトルに対して基本的な操作を行う行列でwが0になることはありえない
-	result.x /= w; // w=1がデカルト座標系であるので、w除算することで同時座標をデカルト座標に戻す
-	result.y /= w;
-	result.z /= w;
+	for (int j = 0; j < 3; ++j) {
+		result.m[3][j] = -(m[3][0] * result.m[0][j] + m[3][1] * result.m[1][j] + m[3][2] * result.m[2][j]);
+	}
 	return result;
 }
 
@@ -260,13 +296,111 @@ Mat4 Mat4::RotateZ(const float radian) {
 }
 
 Mat4 Mat4::Affine(const Vec3& scale, const Vec3& rotate, const Vec3& translate) {
-	const Mat4 s = Scale(scale);
-	const Mat4 rx = RotateX(rotate.x);
-	const Mat4 ry = RotateY(rotate.y);
-	const Mat4 rz = RotateZ(rotate.z);
-	const Mat4 t = Translate(translate);
+	// S * Rx * Ry * Rz * T を展開した式で直接組み立てる
+	const float sx = std::sin(rotate.x);
+	const float cx = std::cos(rotate.x);
+	const float sy = std::sin(rotate.y);
+	const float cy = std::cos(rotate.y);
+	const float sz = std::sin(rotate.z);
+	const float cz = std::cos(rotate.z);
 
-	return s * rx * ry * rz * t;
+	return {
+		{
+			{scale.x * cy * cz, scale.x * cy * sz, scale.x * -sy, 0.0f},
+			{scale.y * (sx * sy * cz - cx * sz), scale.y * (sx * sy * sz + cx * cz), scale.y * sx * cy, 0.0f},
+			{scale.z * (cx * sy * cz + sx * sz), scale.z * (cx * sy * sz - sx * cz), scale.z * cx * cy, 0.0f},
+			{translate.x, translate.y, translate.z, 1.0f}
+		},
+	};
+}
+
+void Mat4::AffineBatch(const std::span<const Vec3> scales, const std::span<const Vec3> rotations,
+	const std::span<const Vec3> translations, const std::span<Mat4> outMatrices) {
+	assert(scales.size() == outMatrices.size() && rotations.size() == outMatrices.size() &&
+		translations.size() == outMatrices.size() && "Array sizes must match");
+
+	// kLanes個ずつ成分ごとの配列に詰め替え、分岐のないレーンループで計算する
+	constexpr size_t kLanes = 8;
+	const size_t count = outMatrices.size();
+	for (size_t base = 0; base < count; base += kLanes) {
+		const size_t lanes = std::min(kLanes, count - base);
+
+		// x, y, zの角度を続けて並べ、sin/cosを1回のループで求める
+		float angles[kLanes * 3] = {};
+		for (size_t l = 0; l < lanes; ++l) {
+			angles[l] = rotations[base + l].x;
+			angles[kLanes + l] = rotations[base + l].y;
+			angles[kLanes * 2 + l] = rotations[base + l].z;
+		}
+		float sines[kLanes * 3];
+		float cosines[kLanes * 3];
+		SinCos(angles, sines, cosines);
+
+		for (size_t l = 0; l < lanes; ++l) {
+			const float sx = sines[l];
+			const float cx = cosines[l];
+			const float sy = sines[kLanes + l];
+			const float cy = cosines[kLanes + l];
+			const float sz = sines[kLanes * 2 + l];
+			const float cz = cosines[kLanes * 2 + l];
+			const Vec3& scale = scales[base + l];
+			const Vec3& translate = translations[base + l];
+
+			outMatrices[base + l] = {
+				{
+					{scale.x * cy * cz, scale.x * cy * sz, scale.x * -sy, 0.0f},
+					{scale.y * (sx * sy * cz - cx * sz), scale.y * (sx * sy * sz + cx * cz), scale.y * sx * cy, 0.0f},
+					{scale.z * (cx * sy * cz + sx * sz), scale.z * (cx * sy * sz - sx * cz), scale.z * cx * cy, 0.0f},
+					{translate.x, translate.y, translate.z, 1.0f}
+				},
+			};
+		}
+	}
+}
+
+void Mat4::AffineBatch(const std::span<const Vec3> scales, const std::span<const Quaternion> rotations,
+	const std::span<const Vec3> translations, const std::span<Mat4> outMatrices) {
+	assert(scales.size() == outMatrices.size() && rotations.size() == outMatrices.size() &&
+		translations.size() == outMatrices.size() && "Array sizes must match");
+
+	// 三角関数がないので1つずつ組み立てるだけでよい
+	const size_t count = outMatrices.size();
+	for (size_t i = 0; i < count; ++i) {
+		outMatrices[i] = Affine(scales[i], rotations[i], translations[i]);
+	}
+}
+
+void Mat4::SinCos(const std::span<const float> radians, const std::span<float> outSin, const std::span<float> outCos) {
+	assert(outSin.size() == radians.size() && outCos.size() == radians.size() && "Array sizes must match");
+
+	// π/2の倍数を引いて [-π/4, π/4] に縮め、多項式で近似する (Cephesのsinf/cosfと同じ係数)
+	// π/2は3つに分けて引き、丸め誤差を抑える
+	constexpr float kTwoOverPi = 0.636619772f;
+	constexpr float kPiOver2A = 1.5703125f;
+	constexpr float kPiOver2B = 4.837512969970703125e-4f;
+	constexpr float kPiOver2C = 7.54978995489188216e-8f;
+	// 1.5 * 2^23 を足して引くと最も近い整数に丸まる (関数呼び出しにしないのでループがSIMD化される)
+	constexpr float kRoundMagic = 12582912.0f;
+
+	const size_t count = radians.size();
+	for (size_t i = 0; i < count; ++i) {
+		const float x = radians[i];
+		const float quadrant = (x * kTwoOverPi + kRoundMagic) - kRoundMagic;
+		const float r = ((x - quadrant * kPiOver2A) - quadrant * kPiOver2B) - quadrant * kPiOver2C;
+		const float r2 = r * r;
+
+		const float sinR = r + r * r2 * (-1.6666654611e-1f + r2 * (8.3321608736e-3f + r2 * -1.9515295891e-4f));
+		const float cosR = 1.0f - 0.5f * r2 +
+			r2 * r2 * (4.166664568298827e-2f + r2 * (-1.388731625493765e-3f + r2 * 2.443315711809948e-5f));
+
+		// 象限に応じてsinとcosを入れ替え、符号を反転する
+		const int q = static_cast<int>(quadrant);
+		const bool swap = (q & 1) != 0;
+		const float sinValue = swap ? cosR : sinR;
+		const float cosValue = swap ? sinR : cosR;
+		outSin[i] = (q & 2) != 0 ? -sinValue : sinValue;
+		outCos[i] = ((q + 1) & 2) != 0 ? -cosValue : cosValue;
+	}
 }
 
 Mat4 Mat4::PerspectiveFovMat(const float fov, const float aspectRatio, const float nearClip, const float farClip,
@@ -324,3 +458,80 @@ Mat4 Mat4::ViewportMat(const float left, const float top, const float width, con
 
 	return result;
 }
+
+namespace {
+	enum class TransformMode {
+		Point, // (x, y, z, 1)
+		Project, // (x, y, z, 1) をw除算
+		Normal // (x, y, z, 0)
+	};
+
+	// これより少ない数ではスレッドに分けない
+	constexpr uint32_t kTransformParallelThreshold = 16384;
+
+	template <TransformMode kMode>
+	void TransformRange(const std::span<const Vec3> source, const Mat4& matrix, const std::span<Vec3> destination,
+		const uint32_t begin, const uint32_t end) {
+		const float (&m)[4][4] = matrix.m;
+		// 各成分 = x * m[0][j] + y * m[1][j] + z * m[2][j] (+ m[3][j])
+		const auto Row = [&](const auto& x, const auto& y, const auto& z, const int j) {
+			using Value = std::remove_cvref_t<decltype(x)>;
+			const Value linear = x * Value(m[0][j]) + y * Value(m[1][j]) + z * Value(m[2][j]);
+			return kMode == TransformMode::Normal ? linear : linear + Value(m[3][j]);
+		};
+		const auto Apply = [&](const auto& v) {
+			auto x = Row(v.x, v.y, v.z, 0);
+			auto y = Row(v.x, v.y, v.z, 1);
+			auto z = Row(v.x, v.y, v.z, 2);
+			if constexpr (kMode == TransformMode::Project) {
+				const auto w = Row(v.x, v.y, v.z, 3);
+				x = x / w;
+				y = y / w;
+				z = z / w;
+			}
+			return std::remove_cvref_t<decltype(v)>(x, y, z);
+		};
+
+		using Packet = Vec3Packet<kNativePacketWidth>;
+		uint32_t i = begin;
+		for (; i + kNativePacketWidth <= end; i += kNativePacketWidth) {
+			Apply(Packet::Load(&source[i])).Store(&destination[i]);
+		}
+		for (; i < end; ++i) {
+			destination[i] = Apply(source[i]);
+		}
+	}
+
+	template <TransformMode kMode>
+	void TransformArray(const std::span<const Vec3> source, const Mat4& matrix, const std::span<Vec3> destination,
+		ThreadPool* pool) {
+		assert(source.size() == destination.size() && "Array sizes must match");
+
+		const uint32_t count = static_cast<uint32_t>(source.size());
+		if (pool == nullptr || count < kTransformParallelThreshold) {
+			TransformRange<kMode>(source, matrix, destination, 0, count);
+			return;
+		}
+
+		// 区切りをパケットの幅にそろえて端数を減らす
+		const uint32_t grainSize = (count / (pool->GetConcurrency() * 4) + 7) / 8 * 8;
+		pool->ParallelFor(count, grainSize, [&](const uint32_t begin, const uint32_t end) {
+			TransformRange<kMode>(source, matrix, destination, begin, end);
+		});
+	}
+}
+
+void Mat4::TransformPoints(const std::span<const Vec3> points, const Mat4& matrix, const std::span<Vec3> outPoints,
+	ThreadPool* pool) {
+	TransformArray<TransformMode::Point>(points, matrix, outPoints, pool);
+}
+
+void Mat4::ProjectPoints(const std::span<const Vec3> points, const Mat4& matrix, const std::span<Vec3> outPoints,
+	ThreadPool* pool) {
+	TransformArray<TransformMode::Project>(points, matrix, outPoints, pool);
+}
+
+void Mat4::TransformNormals(const std::span<const Vec3> normals, const Mat4& matrix, const std::span<Vec3> outNormals,
+	ThreadPool* pool) {
+	TransformArray<TransformMode::Normal>(normals, matrix, outNormals, pool);
+}
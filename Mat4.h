@@ -1,7 +1,12 @@
 #pragma once
+#include <cassert>
+#include <span>
 
+#include "Quaternion.h"
 #include "Vec3.h"
 
+class ThreadPool;
+
 enum class FovAxis {
 	Horizontal,
 	Vertical
@@ -10,25 +15,165 @@ enum class FovAxis {
 struct Mat4 final {
 	float m[4][4];
 
-	Mat4 operator+(const Mat4& rhs) const;
-	Mat4 operator-(const Mat4& rhs) const;
+	constexpr Mat4 operator+(const Mat4& rhs) const {
+		Mat4 result = {};
+		for (int i = 0; i < 4; ++i) {
+			for (int j = 0; j < 4; ++j) {
+				result.m[i][j] = m[i][j] + rhs.m[i][j];
+			}
+		}
+		return result;
+	}
+
+	constexpr Mat4 operator-(const Mat4& rhs) const {
+		Mat4 result = {};
+		for (int i = 0; i < 4; ++i) {
+			for (int j = 0; j < 4; ++j) {
+				result.m[i][j] = m[i][j] - rhs.m[i][j];
+			}
+		}
+		return result;
+	}
+
 	Mat4 operator*(const Mat4& rhs) const;
 
 	Mat4 Inverse() const;
+	// 最後の列が (0, 0, 0, 1) のアフィン変換専用の逆行列 (スケールやせん断も可)
+	Mat4 InverseAffine() const;
+	// 回転と平行移動だけからなる変換専用の逆行列 (3x3を転置して平行移動を戻す)
+	Mat4 InverseRigid() const;
 	Mat4 Transpose() const;
 
-	static Mat4 Identity();
-	static Mat4 Translate(const Vec3& translate);
-	static Mat4 Scale(const Vec3& scale);
+	static constexpr Mat4 Identity() {
+		return {
+			{
+				{1.0f, 0.0f, 0.0f, 0.0f},
+				{0.0f, 1.0f, 0.0f, 0.0f},
+				{0.0f, 0.0f, 1.0f, 0.0f},
+				{0.0f, 0.0f, 0.0f, 1.0f}
+			},
+		};
+	}
+
+	static constexpr Mat4 Translate(const Vec3& translate) {
+		return {
+			{
+				{1.0f, 0.0f, 0.0f, 0.0f},
+				{0.0f, 1.0f, 0.0f, 0.0f},
+				{0.0f, 0.0f, 1.0f, 0.0f},
+				{translate.x, translate.y, translate.z, 1.0f}
+			},
+		};
+	}
+
+	static constexpr Mat4 Scale(const Vec3& scale) {
+		return {
+			{
+				{scale.x, 0.0f, 0.0f, 0.0f},
+				{0.0f, scale.y, 0.0f, 0.0f},
+				{0.0f, 0.0f, scale.z, 0.0f},
+				{0.0f, 0.0f, 0.0f, 1.0f}
+			},
+		};
+	}
+
+	/// <summary>
+	/// 点 (x, y, z, 1) を変換してw除算します
+	/// </summary>
+	static constexpr Vec3 Transform(const Vec3& vector, const Mat4& matrix) {
+		const float x = vector.x * matrix.m[0][0] + vector.y * matrix.m[1][0] + vector.z * matrix.m[2][0] + matrix.m[3][0];
+		const float y = vector.x * matrix.m[0][1] + vector.y * matrix.m[1][1] + vector.z * matrix.m[2][1] + matrix.m[3][1];
+		const float z = vector.x * matrix.m[0][2] + vector.y * matrix.m[1][2] + vector.z * matrix.m[2][2] + matrix.m[3][2];
+		const float w = vector.x * matrix.m[0][3] + vector.y * matrix.m[1][3] + vector.z * matrix.m[2][3] + matrix.m[3][3];
+		assert(w != 0.0f); // ベクトルに対して基本的な操作を行う行列でwが0になることはありえない
+		return {x / w, y / w, z / w};
+	}
+
+	/// <summary>
+	/// 方向ベクトル (x, y, z, 0) を変換します (平行移動は効きません)
+	/// </summary>
+	static constexpr Vec3 TransformNormal(const Vec3& vector, const Mat4& matrix) {
+		return {
+			vector.x * matrix.m[0][0] + vector.y * matrix.m[1][0] + vector.z * matrix.m[2][0],
+			vector.x * matrix.m[0][1] + vector.y * matrix.m[1][1] + vector.z * matrix.m[2][1],
+			vector.x * matrix.m[0][2] + vector.y * matrix.m[1][2] + vector.z * matrix.m[2][2]
+		};
+	}
 
-	static Vec3 Transform(const Vec3& vector, const Mat4& matrix);
+	/// <summary>
+	/// 点の配列をまとめて変換します (アフィン変換としてw除算はしません)
+	/// パケット (Vec3Packet) でまとめて計算し、poolを渡すと大きな配列はスレッドに分けます
+	/// pointsとoutPointsは同じ配列でも構いません
+	/// </summary>
+	static void TransformPoints(std::span<const Vec3> points, const Mat4& matrix, std::span<Vec3> outPoints,
+		ThreadPool* pool = nullptr);
+
+	/// <summary>
+	/// 点の配列をまとめて変換してw除算します (射影行列用)
+	/// Transformと違いwが0かは確かめないので、そうなる点は呼び出し側で除いてください
+	/// </summary>
+	static void ProjectPoints(std::span<const Vec3> points, const Mat4& matrix, std::span<Vec3> outPoints,
+		ThreadPool* pool = nullptr);
+
+	/// <summary>
+	/// 方向ベクトルの配列をまとめて変換します
+	/// </summary>
+	static void TransformNormals(std::span<const Vec3> normals, const Mat4& matrix, std::span<Vec3> outNormals,
+		ThreadPool* pool = nullptr);
 
 	static Mat4 RotateX(float radian);
 	static Mat4 RotateY(float radian);
 	static Mat4 RotateZ(float radian);
+	// クォータニオンの回転行列 (三角関数を使いません)
+	static constexpr Mat4 Rotate(const Quaternion& rotate) {
+		return Affine(Vec3::one, rotate, Vec3::zero);
+	}
 
 	static Mat4 Affine(const Vec3& scale, const Vec3& rotate, const Vec3& translate);
 
+	/// <summary>
+	/// S * R(rotate) * T を直接組み立てます (rotateは単位クォータニオン)
+	/// </summary>
+	static constexpr Mat4 Affine(const Vec3& scale, const Quaternion& rotate, const Vec3& translate) {
+		const float xx = rotate.x * rotate.x;
+		const float yy = rotate.y * rotate.y;
+		const float zz = rotate.z * rotate.z;
+		const float xy = rotate.x * rotate.y;
+		const float xz = rotate.x * rotate.z;
+		const float yz = rotate.y * rotate.z;
+		const float wx = rotate.w * rotate.x;
+		const float wy = rotate.w * rotate.y;
+		const float wz = rotate.w * rotate.z;
+
+		return {
+			{
+				{scale.x * (1.0f - 2.0f * (yy + zz)), scale.x * 2.0f * (xy + wz), scale.x * 2.0f * (xz - wy), 0.0f},
+				{scale.y * 2.0f * (xy - wz), scale.y * (1.0f - 2.0f * (xx + zz)), scale.y * 2.0f * (yz + wx), 0.0f},
+				{scale.z * 2.0f * (xz + wy), scale.z * 2.0f * (yz - wx), scale.z * (1.0f - 2.0f * (xx + yy)), 0.0f},
+				{translate.x, translate.y, translate.z, 1.0f}
+			},
+		};
+	}
+
+	/// <summary>
+	/// 成分ごとの配列 (SoA) からまとめてアフィン変換行列を作ります
+	/// 結果はAffineと同じです (sin/cosは多項式近似なので誤差は1e-6程度)
+	/// </summary>
+	static void AffineBatch(std::span<const Vec3> scales, std::span<const Vec3> rotations,
+		std::span<const Vec3> translations, std::span<Mat4> outMatrices);
+
+	/// <summary>
+	/// 成分ごとの配列 (SoA) からまとめてアフィン変換行列を作ります (回転はクォータニオン)
+	/// </summary>
+	static void AffineBatch(std::span<const Vec3> scales, std::span<const Quaternion> rotations,
+		std::span<const Vec3> translations, std::span<Mat4> outMatrices);
+
+	/// <summary>
+	/// sinとcosをまとめて求めます
+	/// 分岐のないループなのでSIMD命令にまとめられます (|radian|が数千以下で精度が出ます)
+	/// </summary>
+	static void SinCos(std::span<const float> radians, std::span<float> outSin, std::span<float> outCos);
+
 	static Mat4 PerspectiveFovMat(const float fov, const float aspectRatio, const float nearClip, const float farClip,
 		FovAxis fovAxis);
 	static Mat4 OrthographicMat(float left, float top, float right, float bottom,
@@ -0,0 +1,133 @@
+#include "MortonSort.h"
+
+#include <algorithm>
+
+#include "Profiler.h"
+#include "ThreadPool.h"
+
+namespace {
+	// 1軸あたりの格子の最大値 (10bit)
+	constexpr float kGridMax = 1023.0f;
+	constexpr uint32_t kCodeBits = 30;
+
+	// 基数ソートの1パスで見る桁
+	constexpr uint32_t kRadixBits = 8;
+	constexpr uint32_t kRadix = 1u << kRadixBits;
+
+	// これより少ない点数ではスレッドに分けない
+	constexpr uint32_t kParallelThreshold = 4096;
+	// 基数ソートの1ブロックの最小点数
+	constexpr uint32_t kMinBlockSize = 2048;
+
+	/// <summary>
+	/// poolがあれば [0, count) をスレッドへ分け、なければその場で実行します
+	/// </summary>
+	template <typename Func>
+	void ForEachRange(ThreadPool* pool, const uint32_t count, const uint32_t grainSize, const Func& func) {
+		if (pool != nullptr) {
+			pool->ParallelFor(count, grainSize, func);
+		} else {
+			func(0, count);
+		}
+	}
+}
+
+void MortonSort::Sort(const std::span<const Vec3> positions, ThreadPool* pool) {
+	PROFILE_ZONE("MortonSort::Sort");
+
+	const uint32_t count = static_cast<uint32_t>(positions.size());
+	codes_.resize(count);
+	order_.resize(count);
+	codesTemp_.resize(count);
+	orderTemp_.resize(count);
+	if (count == 0) {
+		return;
+	}
+
+	Vec3 minimum = positions[0];
+	Vec3 maximum = positions[0];
+	for (const Vec3& position : positions) {
+		minimum = {std::min(minimum.x, position.x), std::min(minimum.y, position.y), std::min(minimum.z, position.z)};
+		maximum = {std::max(maximum.x, position.x), std::max(maximum.y, position.y), std::max(maximum.z, position.z)};
+	}
+
+	// 一番長い辺に合わせて等方に量子化する (平たいシーンでも近さの比が崩れない)
+	const Vec3 extent = maximum - minimum;
+	const float longest = std::max({extent.x, extent.y, extent.z});
+	const float scale = longest > 0.0f ? kGridMax / longest : 0.0f;
+
+	const auto Encode = [&](const uint32_t begin, const uint32_t end) {
+		for (uint32_t i = begin; i < end; ++i) {
+			const Vec3 cell = (positions[i] - minimum) * scale;
+			codes_[i] = MortonCode(static_cast<uint32_t>(std::min(cell.x, kGridMax)),
+				static_cast<uint32_t>(std::min(cell.y, kGridMax)), static_cast<uint32_t>(std::min(cell.z, kGridMax)));
+			order_[i] = i;
+		}
+	};
+	ForEachRange(count >= kParallelThreshold ? pool : nullptr, count, kMinBlockSize, Encode);
+
+	RadixSort(pool);
+}
+
+void MortonSort::RadixSort(ThreadPool* pool) {
+	const uint32_t count = static_cast<uint32_t>(codes_.size());
+	if (count < kParallelThreshold) {
+		pool = nullptr;
+	}
+
+	// ブロックの中は元の順に処理し、書き込み位置はブロック順に割り当てるので安定ソートになる
+	const uint32_t blockCount = pool != nullptr
+		? std::clamp(count / kMinBlockSize, 1u, pool->GetConcurrency() * 4)
+		: 1;
+	const uint32_t blockSize = (count + blockCount - 1) / blockCount;
+	histograms_.resize(blockCount * kRadix);
+
+	for (uint32_t shift = 0; shift < kCodeBits; shift += kRadixBits) {
+		// ブロックごとに桁を数える
+		const auto Count = [&](const uint32_t begin, const uint32_t end) {
+			for (uint32_t block = begin; block < end; ++block) {
+				uint32_t* histogram = histograms_.data() + block * kRadix;
+				std::fill(histogram, histogram + kRadix, 0u);
+				const uint32_t last = std::min(count, (block + 1) * blockSize);
+				for (uint32_t i = block * blockSize; i < last; ++i) {
+					++histogram[(codes_[i] >> shift) & (kRadix - 1)];
+				}
+			}
+		};
+		ForEachRange(pool, blockCount, 1, Count);
+
+		// 桁の小さい順、同じ桁ならブロック順に書き込み先の先頭を決める
+		bool allSameDigit = false;
+		uint32_t offset = 0;
+		for (uint32_t digit = 0; digit < kRadix; ++digit) {
+			const uint32_t digitBegin = offset;
+			for (uint32_t block = 0; block < blockCount; ++block) {
+				uint32_t& slot = histograms_[block * kRadix + digit];
+				const uint32_t digitCount = slot;
+				slot = offset;
+				offset += digitCount;
+			}
+			allSameDigit = allSameDigit || offset - digitBegin == count;
+		}
+		// 全部同じ桁なら並びは変わらない (上位の桁は空いていることが多い)
+		if (allSameDigit) {
+			continue;
+		}
+
+		const auto Scatter = [&](const uint32_t begin, const uint32_t end) {
+			for (uint32_t block = begin; block < end; ++block) {
+				uint32_t* cursor = histograms_.data() + block * kRadix;
+				const uint32_t last = std::min(count, (block + 1) * blockSize);
+				for (uint32_t i = block * blockSize; i < last; ++i) {
+					const uint32_t destination = cursor[(codes_[i] >> shift) & (kRadix - 1)]++;
+					codesTemp_[destination] = codes_[i];
+					orderTemp_[destination] = order_[i];
+				}
+			}
+		};
+		ForEachRange(pool, blockCount, 1, Scatter);
+
+		codes_.swap(codesTemp_);
+		order_.swap(orderTemp_);
+	}
+}
@@ -0,0 +1,67 @@
+#pragma once
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include "Vec3.h"
+
+class ThreadPool;
+
+/// <summary>
+/// 10bitの値の各ビットの間に2bitずつ空けます (モートンコード用)
+/// </summary>
+constexpr uint32_t ExpandBits(uint32_t value) {
+	value = (value * 0x00010001u) & 0xFF0000FFu;
+	value = (value * 0x00000101u) & 0x0F00F00Fu;
+	value = (value * 0x00000011u) & 0xC30C30C3u;
+	value = (value * 0x00000005u) & 0x49249249u;
+	return value;
+}
+
+/// <summary>
+/// 10bitずつの格子座標から30bitのモートンコード (Zオーダー) を作ります
+/// </summary>
+constexpr uint32_t MortonCode(const uint32_t x, const uint32_t y, const uint32_t z) {
+	return (ExpandBits(x) << 2) | (ExpandBits(y) << 1) | ExpandBits(z);
+}
+
+/// <summary>
+/// 点の集合をモートンコード順に並べる
+/// 全体のAABBを1024分割した格子で量子化し、コードを基数ソートします
+/// 同じコードの点は元の順を保つので、スレッド数によらず同じ結果になります
+/// </summary>
+class MortonSort {
+public:
+	/// <summary>
+	/// positionsをコード順に並べたときの添字の並びを求めます
+	/// poolを渡すとコードの計算と基数ソートをスレッドへ分けます
+	/// </summary>
+	void Sort(std::span<const Vec3> positions, ThreadPool* pool = nullptr);
+
+	/// <summary>
+	/// 並べ替えた後のi番目に来る元の添字
+	/// </summary>
+	std::span<const uint32_t> GetOrder() const {
+		return order_;
+	}
+
+	/// <summary>
+	/// 並べ替えた後の順のモートンコード (昇順)
+	/// </summary>
+	std::span<const uint32_t> GetCodes() const {
+		return codes_;
+	}
+
+private:
+	/// <summary>
+	/// codes_とorder_をコードの昇順に並べ替えます (8bitずつのLSD基数ソート)
+	/// </summary>
+	void RadixSort(ThreadPool* pool);
+
+	std::vector<uint32_t> codes_;
+	std::vector<uint32_t> order_;
+	std::vector<uint32_t> codesTemp_;
+	std::vector<uint32_t> orderTemp_;
+	// ブロックごとの桁のヒストグラム (ブロック数 x 基数)
+	std::vector<uint32_t> histograms_;
+};
@@ -3,29 +3,44 @@
 #include <imgui.h>
 
 #include "Camera.h"
-
-std::vector<std::shared_ptr<Object>> Object::GetChildren() {
-	return children_;
-}
+#include "Profiler.h"
 
 void Object::SetParent(const std::shared_ptr<Object>& parentObject) {
 	parent_ = parentObject;
 }
 
-void Object::SetTransform(Vec3 pos, Vec3 rotate, Vec3 scale) {
-	for (int i = 0; i < 3; ++i) {
-		transform_.translation_[i] = pos[i];
-		transform_.rotation_[i] = rotate[i];
-		transform_.scale_[i] = scale[i];
-	}
+void Object::SetTransform(const Vec3 pos, const Quaternion& rotate, const Vec3 scale) {
+	transform_.translation_ = pos;
+	SetRotation(rotate);
+	transform_.scale_ = scale;
+}
+
+void Object::SetTransform(const Vec3 pos, const Vec3 eulerRotate, const Vec3 scale) {
+	transform_.translation_ = pos;
+	SetEulerRotation(eulerRotate);
+	transform_.scale_ = scale;
 }
 
 void Object::SetTransform(WorldTransform& newTransform) {
-	for (int i = 0; i < 3; ++i) {
-		transform_.translation_[i] = newTransform.translation_[i];
-		transform_.rotation_[i] = newTransform.rotation_[i];
-		transform_.scale_[i] = newTransform.scale_[i];
+	transform_.translation_ = newTransform.translation_;
+	SetEulerRotation(newTransform.rotation_.ConvertToVec3());
+	transform_.scale_ = newTransform.scale_;
+}
+
+void Object::SetRotation(const Quaternion& rotate) {
+	if (rotate == rotation_) {
+		return;
 	}
+	rotation_ = rotate;
+	transform_.rotation_ = rotate.ToEuler();
+}
+
+void Object::SetEulerRotation(const Vec3& eulerRotate) {
+	if (eulerRotate == transform_.rotation_.ConvertToVec3()) {
+		return;
+	}
+	transform_.rotation_ = eulerRotate;
+	rotation_ = Quaternion::FromEuler(eulerRotate);
 }
 
 Object::Object(std::string name, std::string tag, const bool active) : name_(std::move(name)), tag_(std::move(tag)),
@@ -38,6 +53,7 @@ void Object::Initialize(const std::string& name) {
 }
 
 void Object::Update() {
+	PROFILE_ZONE("Object::Update");
 	for (auto& child : children_) {
 		child->Update();
 	}
@@ -56,10 +72,13 @@ void Object::Details() {
 			transform_.translation_ = {0.0f,0.0f,0.0f};
 		}
 
-		ImGui::DragFloat3("Rotation ", &transform_.rotation_.x, 0.01f);
+		// オイラー角で編集し、変えたときだけクォータニオンに直す
+		if (ImGui::DragFloat3("Rotation ", &transform_.rotation_.x, 0.01f)) {
+			rotation_ = Quaternion::FromEuler(transform_.rotation_.ConvertToVec3());
+		}
 		ImGui::SameLine();
 		if (ImGui::ArrowButton("RotReset", ImGuiDir_Left)) {
-			transform_.rotation_ = {0.0f,0.0f,0.0f};
+			SetRotation(Quaternion::Identity());
 		}
 
 		Vector3 initScale = transform_.scale_;
@@ -105,6 +124,6 @@ void Object::Details() {
 	ImGui::End();
 }
 
-std::string Object::GetName() {
+const std::string& Object::GetName() const {
 	return name_;
 }
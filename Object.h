@@ -1,6 +1,7 @@
 #pragma once
 #include <format>
 #include <memory>
+#include <span>
 #include <string>
 #include <vector>
 
@@ -13,15 +14,22 @@ class Camera;
 class Object : public std::enable_shared_from_this<Object> {
 public:
 	virtual ~Object() = default;
-	Transform GetTransform() {
-		Transform ret;
-		for (int i = 0; i < 3; ++i) {
-			ret.position[i] = transform_.translation_[i];
-			ret.rotation[i] = transform_.rotation_[i];
-			ret.scale[i] = transform_.scale_[i];
-		}
-
-		return ret;
+	/// <summary>
+	/// 位置・回転 (クォータニオン)・スケール
+	/// </summary>
+	Transform GetTransform() const {
+		return {
+			transform_.translation_.ConvertToVec3(),
+			rotation_,
+			transform_.scale_.ConvertToVec3()
+		};
+	}
+
+	/// <summary>
+	/// 回転をオイラー角で返します (編集用)
+	/// </summary>
+	Vec3 GetEulerRotation() const {
+		return transform_.rotation_.ConvertToVec3();
 	}
 
 	WorldTransform* GetWorldTransform() {
@@ -34,10 +42,19 @@ public:
 	virtual void Draw(const ViewProjection& viewProjection);
 	virtual void Details();
 
-	std::vector<std::shared_ptr<Object>> GetChildren();
-	void SetTransform(Vec3 pos, Vec3 rotate, Vec3 scale);
+	/// <summary>
+	/// 子の一覧 (コピーせずに参照します)
+	/// </summary>
+	std::span<const std::shared_ptr<Object>> Children() const {
+		return children_;
+	}
+	void SetTransform(Vec3 pos, const Quaternion& rotate, Vec3 scale);
+	/// <summary>
+	/// 回転をオイラー角で設定します (編集用、変わったときだけクォータニオンに変換します)
+	/// </summary>
+	void SetTransform(Vec3 pos, Vec3 eulerRotate, Vec3 scale);
 	void SetTransform(WorldTransform& newTransform);
-	std::string GetName();
+	const std::string& GetName() const;
 
 	void SetParent(const std::shared_ptr<Object>& parentObject);
 
@@ -52,7 +69,19 @@ public:
 	}
 
 protected:
+	/// <summary>
+	/// 回転を設定し、編集用のオイラー角も合わせます
+	/// </summary>
+	void SetRotation(const Quaternion& rotate);
+
+	/// <summary>
+	/// オイラー角で回転を設定します
+	/// </summary>
+	void SetEulerRotation(const Vec3& eulerRotate);
+
+	// transform_.rotation_ は編集用のオイラー角で、回転の本体はrotation_が持つ
 	WorldTransform transform_;
+	Quaternion rotation_;
 	std::string name_;
 	std::string tag_;
 	bool active_;
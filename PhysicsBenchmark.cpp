@@ -0,0 +1,354 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "LinearBvh.h"
+#include "Mat4.h"
+#include "PhysicsWorld.h"
+#include "SceneDescription.h"
+#include "Solver.h"
+#include "SpatialGrid.h"
+#include "ThreadPool.h"
+#include "VerletList.h"
+#include "WorldSweep.h"
+
+// 物理の各段階と1ステップ全体を、シーンの種類と剛体数を変えて計測するベンチマーク
+//
+//   PhysicsBenchmark [--max-bodies <n>] [--min-ms <ms>] [--scene <name>] [--bench <name>] [--threads <n>]
+//
+// 出力はCSVで、scalingは1つ前の剛体数からの計算量の指数 (1.0なら線形)
+// --threads を2以上 (0ならハードウェアスレッド数) にすると、LBVHの構築・ペア探索、並べ替え、Stepにスレッドプールを渡します
+
+namespace {
+	struct BenchmarkOptions {
+		uint32_t maxBodies = 1000000;
+		double minMilliseconds = 200.0;
+		std::string scene; // 空なら全シーン
+		std::string bench; // 空なら全ベンチマーク
+		uint32_t threads = 1; // 呼び出し元を含めた並列度 (0ならハードウェアスレッド数)
+		ThreadPool* pool = nullptr; // 並列度が2以上のときだけmainで設定する
+	};
+
+	struct SceneGenerator {
+		const char* name;
+		std::function<SceneDescription(uint32_t)> make;
+	};
+
+	struct Result {
+		std::string bench;
+		std::string scene;
+		uint32_t bodies = 0;
+		double nanosecondsPerCall = 0.0;
+		uint64_t work = 0; // ペア数など参考値
+	};
+
+	/// <summary>
+	/// funcをminMilliseconds以上かつ3回以上繰り返し、1回あたりの中央値 (ns) を返します
+	/// </summary>
+	double Measure(const std::function<void()>& func, const double minMilliseconds) {
+		using Clock = std::chrono::steady_clock;
+
+		// 1回目はキャッシュやメモリ確保の影響が大きいので捨てる
+		func();
+
+		std::vector<double> samples;
+		double total = 0.0;
+		while (samples.size() < 3 || total < minMilliseconds) {
+			const auto start = Clock::now();
+			func();
+			const double ms = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+			samples.push_back(ms);
+			total += ms;
+		}
+
+		std::sort(samples.begin(), samples.end());
+		return samples[samples.size() / 2] * 1.0e6;
+	}
+
+	bool Selected(const std::string& filter, const char* name) {
+		return filter.empty() || filter == name;
+	}
+
+	/// <summary>
+	/// 結果を記録してCSVの1行を出します
+	/// </summary>
+	void RecordResult(const char* bench, const char* sceneName, const uint32_t count, const double ns,
+		const uint64_t work, const ThreadPool* pool, std::vector<Result>& outResults) {
+		outResults.push_back({bench, sceneName, count, ns, work});
+		const Result& result = outResults.back();
+
+		// 同じベンチマークとシーンの1つ前の結果から指数を求める
+		double scaling = 0.0;
+		for (auto it = outResults.rbegin() + 1; it != outResults.rend(); ++it) {
+			if (it->bench == result.bench && it->scene == result.scene) {
+				scaling = std::log(result.nanosecondsPerCall / it->nanosecondsPerCall) /
+					std::log(static_cast<double>(result.bodies) / static_cast<double>(it->bodies));
+				break;
+			}
+		}
+
+		const uint32_t threads = pool != nullptr ? pool->GetConcurrency() : 1;
+		std::printf("%s,%s,%u,%.3f,%.3f,%llu,%.3f,%u\n", bench, sceneName, count, ns / count, ns * 1.0e-6,
+			static_cast<unsigned long long>(work), scaling, threads);
+		std::fflush(stdout);
+	}
+
+	void RunScene(const BenchmarkOptions& options, const char* sceneName, const SceneDescription& scene,
+		std::vector<Result>& outResults) {
+		PhysicsWorld world;
+		world.Load(scene);
+		BodyArrays& bodies = world.GetBodies();
+		const uint32_t count = bodies.Size();
+
+		const auto Record = [&](const char* bench, const double ns, const uint64_t work) {
+			RecordResult(bench, sceneName, count, ns, work, options.pool, outResults);
+		};
+
+		SpatialGrid grid;
+		std::vector<BodyPair> pairs;
+
+		if (Selected(options.bench, "grid_build")) {
+			const double ns = Measure([&]() {
+				grid.Build(bodies.positions, bodies.radii);
+			}, options.minMilliseconds);
+			Record("grid_build", ns, 0);
+		}
+
+		grid.Build(bodies.positions, bodies.radii);
+		grid.FindPairs(pairs);
+
+		if (Selected(options.bench, "grid_pairs")) {
+			const double ns = Measure([&]() {
+				grid.FindPairs(pairs);
+			}, options.minMilliseconds);
+			Record("grid_pairs", ns, pairs.size());
+		}
+
+		if (Selected(options.bench, "grid_radius")) {
+			std::vector<uint32_t> offsets;
+			std::vector<uint32_t> neighbors;
+			const float radius = bodies.radii.empty() ? 1.0f : bodies.radii.front() * 2.0f;
+			const double ns = Measure([&]() {
+				grid.BuildNeighborList(radius, offsets, neighbors);
+			}, options.minMilliseconds);
+			Record("grid_radius", ns, neighbors.size());
+		}
+
+		if (Selected(options.bench, "lbvh_build")) {
+			LinearBvh bvh;
+			const double ns = Measure([&]() {
+				bvh.Build(bodies.positions, bodies.radii, options.pool);
+			}, options.minMilliseconds);
+			Record("lbvh_build", ns, 0);
+		}
+
+		if (Selected(options.bench, "lbvh_pairs")) {
+			LinearBvh bvh;
+			bvh.Build(bodies.positions, bodies.radii, options.pool);
+			std::vector<BodyPair> bvhPairs;
+			const double ns = Measure([&]() {
+				bvh.FindPairs(bvhPairs, nullptr, options.pool);
+			}, options.minMilliseconds);
+			Record("lbvh_pairs", ns, bvhPairs.size());
+		}
+
+		if (Selected(options.bench, "verlet_pairs") || Selected(options.bench, "verlet_skipped")) {
+			// 止まったままでは候補を一度も測り直さないので、速度に沿って16ステップ周期で往復させる
+			const float skin = world.GetSettings().verletSkin;
+			const float dt = world.GetSettings().deltaTime;
+			std::vector<Vec3> positions = bodies.positions;
+			VerletList verlet;
+			std::vector<BodyPair> verletPairs;
+			uint32_t phase = 0;
+			uint64_t calls = 0;
+			uint64_t skipped = 0;
+			const double ns = Measure([&]() {
+				const float offset = static_cast<float>(phase < 8 ? phase : 16 - phase) * dt;
+				phase = (phase + 1) % 16;
+				for (uint32_t i = 0; i < count; ++i) {
+					positions[i] = bodies.positions[i] + bodies.velocities[i] * offset;
+				}
+				verlet.FindPairs(positions, bodies.radii, skin, verletPairs);
+				skipped += verlet.GetSkippedCount();
+				++calls;
+			}, options.minMilliseconds);
+			// 位置の更新も含めた1回あたりの時間 (中央値なので、まれな作り直しの回はほぼ入らない)
+			// verlet_skippedのworkは隙間の記録で省いた判定数の平均
+			if (Selected(options.bench, "verlet_pairs")) {
+				Record("verlet_pairs", ns, verletPairs.size());
+			}
+			if (Selected(options.bench, "verlet_skipped")) {
+				Record("verlet_skipped", ns, calls > 0 ? skipped / calls : 0);
+			}
+		}
+
+		if (Selected(options.bench, "contact")) {
+			// 状態を変えないよう速度のコピーに対して解く
+			std::vector<Vec3> velocities = bodies.velocities;
+			const double ns = Measure([&]() {
+				ContactManifold contact;
+				for (const auto& [a, b] : pairs) {
+					if (ComputeSphereContact(bodies.positions[a], bodies.radii[a], bodies.positions[b], bodies.radii[b],
+						contact)) {
+						SolveContactVelocity(contact, velocities[a], bodies.inverseMasses[a], velocities[b],
+							bodies.inverseMasses[b], std::min(bodies.restitutions[a], bodies.restitutions[b]));
+					}
+				}
+			}, options.minMilliseconds);
+			Record("contact", ns, pairs.size());
+		}
+
+		uint64_t links = 0;
+		for (const uint32_t parent : bodies.parents) {
+			links += parent != kNoParent ? 1 : 0;
+		}
+
+		if (links > 0 && Selected(options.bench, "distance")) {
+			std::vector<Vec3> positions = bodies.positions;
+			const double ns = Measure([&]() {
+				for (uint32_t i = 0; i < count; ++i) {
+					const uint32_t parent = bodies.parents[i];
+					if (parent != kNoParent) {
+						SolveDistanceConstraint(positions[parent], bodies.inverseMasses[parent], positions[i],
+							bodies.inverseMasses[i], bodies.maxDistances[i]);
+					}
+				}
+			}, options.minMilliseconds);
+			Record("distance", ns, links);
+		}
+
+		if (Selected(options.bench, "reorder")) {
+			// 並べ替えはスロットが変わるだけなので、その後の計測には影響しない
+			const double ns = Measure([&]() {
+				world.ReorderBodies(options.pool);
+			}, options.minMilliseconds);
+			Record("reorder", ns, 0);
+		}
+
+		if (Selected(options.bench, "mat4_transform") || Selected(options.bench, "mat4_project") ||
+			Selected(options.bench, "mat4_normals")) {
+			// 描画側のカリングと同じく、剛体の中心をまとめてビュー空間・クリップ空間へ移す
+			const Mat4 view = Mat4::Affine(Vec3::one, Vec3{0.3f, 0.5f, 0.0f}, Vec3{0.0f, 20.0f, -200.0f}).InverseAffine();
+			const Mat4 viewProjection = view * Mat4::PerspectiveFovMat(0.8f, 16.0f / 9.0f, 0.1f, 1000.0f, FovAxis::Vertical);
+			std::vector<Vec3> transformed(count);
+			if (Selected(options.bench, "mat4_transform")) {
+				const double ns = Measure([&]() {
+					Mat4::TransformPoints(bodies.positions, view, transformed, options.pool);
+				}, options.minMilliseconds);
+				Record("mat4_transform", ns, 0);
+			}
+			if (Selected(options.bench, "mat4_project")) {
+				const double ns = Measure([&]() {
+					Mat4::ProjectPoints(bodies.positions, viewProjection, transformed, options.pool);
+				}, options.minMilliseconds);
+				Record("mat4_project", ns, 0);
+			}
+			if (Selected(options.bench, "mat4_normals")) {
+				const double ns = Measure([&]() {
+					Mat4::TransformNormals(bodies.velocities, view, transformed, options.pool);
+				}, options.minMilliseconds);
+				Record("mat4_normals", ns, 0);
+			}
+		}
+
+		if (Selected(options.bench, "step")) {
+			const double ns = Measure([&]() {
+				world.Step(options.pool);
+			}, options.minMilliseconds);
+			Record("step", ns, world.GetMetrics().pairCount);
+		}
+	}
+
+	/// <summary>
+	/// 6球の鎖のパラメータスイープを、ワールドごとに回すRunWorldsと8ワールドずつ束ねるRunWorldsBatchedで比べます
+	/// bodiesの列はワールド数、ns_per_bodyは1ワールドあたりの時間
+	/// </summary>
+	void RunSweep(const BenchmarkOptions& options, ThreadPool& pool, std::vector<Result>& outResults) {
+		constexpr uint32_t kSteps = 60;
+		SweepAxes axes;
+		for (uint32_t i = 0; i < 8; ++i) {
+			axes.reductionFactors.push_back(0.05f * static_cast<float>(i));
+			axes.restitutions.push_back(0.1f * static_cast<float>(i + 1));
+		}
+		for (uint32_t i = 0; i < 16; ++i) {
+			axes.massRatios.push_back(1.0f + 0.5f * static_cast<float>(i));
+		}
+		const std::vector<SceneDescription> scenes = MakeSweepScenes(SceneDescription::MakeChain(4), axes);
+		const uint32_t worldCount = static_cast<uint32_t>(scenes.size());
+
+		std::vector<WorldReport> reports;
+		if (Selected(options.bench, "sweep_worlds")) {
+			const double ns = Measure([&]() {
+				RunWorlds(scenes, kSteps, pool, reports);
+			}, options.minMilliseconds);
+			RecordResult("sweep_worlds", "chain6", worldCount, ns, kSteps, &pool, outResults);
+		}
+		if (Selected(options.bench, "sweep_batched")) {
+			const double ns = Measure([&]() {
+				RunWorldsBatched(scenes, kSteps, pool, reports);
+			}, options.minMilliseconds);
+			RecordResult("sweep_batched", "chain6", worldCount, ns, kSteps, &pool, outResults);
+		}
+	}
+}
+
+int main(int argc, char** argv) {
+	BenchmarkOptions options;
+	for (int i = 1; i + 1 < argc; i += 2) {
+		const char* arg = argv[i];
+		const char* value = argv[i + 1];
+		if (std::strcmp(arg, "--max-bodies") == 0) {
+			options.maxBodies = static_cast<uint32_t>(std::strtoul(value, nullptr, 10));
+		} else if (std::strcmp(arg, "--min-ms") == 0) {
+			options.minMilliseconds = std::strtod(value, nullptr);
+		} else if (std::strcmp(arg, "--scene") == 0) {
+			options.scene = value;
+		} else if (std::strcmp(arg, "--bench") == 0) {
+			options.bench = value;
+		} else if (std::strcmp(arg, "--threads") == 0) {
+			options.threads = static_cast<uint32_t>(std::strtoul(value, nullptr, 10));
+		} else {
+			std::fprintf(stderr,
+				"usage: PhysicsBenchmark [--max-bodies <n>] [--min-ms <ms>] [--scene <name>] [--bench <name>]"
+				" [--threads <n>]\n");
+			return 2;
+		}
+	}
+
+	const SceneGenerator generators[] = {
+		{"gas", [](const uint32_t count) { return SceneDescription::MakeGas(count); }},
+		{"pile", [](const uint32_t count) { return SceneDescription::MakePile(count); }},
+		{"chain", [](const uint32_t count) { return SceneDescription::MakeChain(std::max(count, 2u) - 2); }},
+		{"lattice", [](const uint32_t count) { return SceneDescription::MakeLattice(count); }},
+	};
+
+	// スイープは並列度1でもプールを使うので常に作り、ほかの計測には2以上のときだけ渡す
+	ThreadPool pool(options.threads == 0 ? ThreadPool::kDefaultWorkerCount : options.threads - 1);
+	if (pool.GetConcurrency() > 1) {
+		options.pool = &pool;
+	}
+
+	std::printf("bench,scene,bodies,ns_per_body,ms_per_call,work,scaling,threads\n");
+
+	std::vector<Result> results;
+	for (const SceneGenerator& generator : generators) {
+		if (!Selected(options.scene, generator.name)) {
+			continue;
+		}
+		for (uint32_t count = 100; count <= options.maxBodies; count *= 10) {
+			RunScene(options, generator.name, generator.make(count), results);
+		}
+	}
+
+	if (Selected(options.scene, "sweep")) {
+		RunSweep(options, pool, results);
+	}
+
+	return 0;
+}
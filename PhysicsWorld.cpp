@@ -0,0 +1,442 @@
+#include "PhysicsWorld.h"
+
+#include <algorithm>
+#include <chrono>
+#include <numeric>
+
+#include "Profiler.h"
+#include "ThreadPool.h"
+
+namespace {
+	// これより少ない剛体数では並べ替えをスレッドに分けない
+	constexpr uint32_t kReorderParallelThreshold = 4096;
+	constexpr uint32_t kReorderGrainSize = 2048;
+}
+
+void PhysicsWorld::Load(const SceneDescription& scene) {
+	settings_ = scene.settings;
+
+	const uint32_t count = static_cast<uint32_t>(scene.bodies.size());
+	bodies_.Clear();
+	bodies_.Resize(count);
+	for (uint32_t i = 0; i < count; ++i) {
+		const BodyDescription& body = scene.bodies[i];
+		bodies_.positions[i] = body.position;
+		bodies_.velocities[i] = body.isStatic ? Vec3::zero : body.velocity;
+		bodies_.masses[i] = body.mass;
+		bodies_.inverseMasses[i] = body.isStatic ? 0.0f : 1.0f / body.mass;
+		bodies_.radii[i] = body.radius;
+		bodies_.restitutions[i] = body.restitution;
+		bodies_.layers[i] = body.collisionLayer;
+		bodies_.masks[i] = body.collisionMask;
+		bodies_.triggers[i] = body.isTrigger ? 1 : 0;
+		bodies_.parents[i] = body.parent;
+
+		if (body.parent != kNoParent) {
+			bodies_.maxDistances[i] = body.maxDistanceToParent >= 0.0f
+				? body.maxDistanceToParent
+				: body.position.Distance(scene.bodies[body.parent].position);
+		}
+	}
+
+	forceGenerators_.Clear();
+	forceGenerators_.gravities.push_back({scene.gravity, BodySelection::All()});
+	forceGenerators_.linearDrags.push_back({scene.linearDrag, BodySelection::All()});
+
+	handleToSlot_.resize(count);
+	slotToHandle_.resize(count);
+	std::iota(handleToSlot_.begin(), handleToSlot_.end(), 0u);
+	std::iota(slotToHandle_.begin(), slotToHandle_.end(), 0u);
+
+	ignoredPairs_.Clear();
+	verlet_.Invalidate();
+
+	triggerCount_ = static_cast<uint32_t>(std::count(bodies_.triggers.begin(), bodies_.triggers.end(), uint8_t(1)));
+	triggerPairs_.clear();
+	previousTriggerPairs_.clear();
+	triggerEvents_.clear();
+
+	// 配列はpairs_と同じく最初の数ステップで伸び、あとは使い回す
+	pairContacts_.clear();
+	contactEvents_.Reset(0);
+
+	// 最初から近い順にしておく (作業用の配列もここで確保され、ステップ中は確保しない)
+	stepsSinceReorder_ = 0;
+	if (settings_.reorderInterval > 0) {
+		ReorderBodies();
+	}
+
+	metrics_ = {};
+}
+
+void PhysicsWorld::Step(ThreadPool* pool) {
+	PROFILE_ZONE("PhysicsWorld::Step");
+	const auto start = std::chrono::steady_clock::now();
+
+	metrics_.maxPenetration = 0.0f;
+
+	IntegrateVelocities();
+
+	// ブロードフェーズ
+	{
+		PROFILE_ZONE("Broadphase");
+		// ふるい分けはブロードフェーズの中で行い、除いた組はナローフェーズに渡さない
+		const CollisionFilter filter = MakeCollisionFilter();
+		switch (settings_.broadphase) {
+		case BroadphaseType::Lbvh:
+			bvh_.Build(bodies_.positions, bodies_.radii, pool);
+			bvh_.FindPairs(pairs_, &filter, pool);
+			break;
+		case BroadphaseType::Verlet:
+			if (settings_.parentCollision != verletParentCollision_) {
+				verletParentCollision_ = settings_.parentCollision;
+				verlet_.Invalidate();
+			}
+			verlet_.FindPairs(bodies_.positions, bodies_.radii, settings_.verletSkin, pairs_, &filter);
+			break;
+		default:
+			grid_.Build(bodies_.positions, bodies_.radii);
+			grid_.FindPairs(pairs_, &filter);
+			break;
+		}
+	}
+	metrics_.pairCount = static_cast<uint32_t>(pairs_.size());
+
+	// トリガーの組はソルバーに渡す前に抜き出す
+	UpdateTriggers();
+
+	SolveConstraints();
+	EmitContactEvents();
+	IntegratePositions();
+
+	if (settings_.reorderInterval > 0 && ++stepsSinceReorder_ >= settings_.reorderInterval) {
+		ReorderBodies(pool);
+		stepsSinceReorder_ = 0;
+	}
+
+	metrics_.kineticEnergy = ComputeKineticEnergy();
+	metrics_.potentialEnergy = forceGenerators_.ComputePotentialEnergy(bodies_);
+
+	const auto end = std::chrono::steady_clock::now();
+	metrics_.stepMilliseconds = std::chrono::duration<double, std::milli>(end - start).count();
+}
+
+bool PhysicsWorld::ReorderBodies(ThreadPool* pool) {
+	PROFILE_ZONE("PhysicsWorld::ReorderBodies");
+
+	// 範囲や添字リストは今のスロットで剛体を選んでいるので、並べ替えると対象がずれる
+	if (forceGenerators_.HasPartialSelections()) {
+		return false;
+	}
+
+	const uint32_t count = bodies_.Size();
+	mortonSort_.Sort(bodies_.positions, pool);
+	const std::span<const uint32_t> order = mortonSort_.GetOrder();
+	newSlots_.resize(count);
+	for (uint32_t slot = 0; slot < count; ++slot) {
+		newSlots_[order[slot]] = slot;
+	}
+
+	// forcesとpseudoVelocitiesはステップの中でしか使わないので並べ替えない
+	Permute(bodies_.positions, vec3Scratch_, pool);
+	Permute(bodies_.velocities, vec3Scratch_, pool);
+	Permute(bodies_.masses, floatScratch_, pool);
+	Permute(bodies_.inverseMasses, floatScratch_, pool);
+	Permute(bodies_.radii, floatScratch_, pool);
+	Permute(bodies_.restitutions, floatScratch_, pool);
+	Permute(bodies_.layers, indexScratch_, pool);
+	Permute(bodies_.masks, indexScratch_, pool);
+	Permute(bodies_.triggers, byteScratch_, pool);
+	Permute(bodies_.maxDistances, floatScratch_, pool);
+	Permute(bodies_.parents, indexScratch_, pool);
+	Permute(slotToHandle_, indexScratch_, pool);
+
+	// 添字で指しているものを新しいスロットに付け替える
+	for (uint32_t& parent : bodies_.parents) {
+		if (parent != kNoParent) {
+			parent = newSlots_[parent];
+		}
+	}
+	for (uint32_t slot = 0; slot < count; ++slot) {
+		handleToSlot_[slotToHandle_[slot]] = slot;
+	}
+	forceGenerators_.RemapBodies(newSlots_);
+	ignoredPairs_.Remap(newSlots_);
+	// 近傍リストは古いスロットで持っている
+	verlet_.Invalidate();
+
+	return true;
+}
+
+void PhysicsWorld::SetCollisionLayer(const uint32_t handle, const uint32_t layer, const uint32_t mask) {
+	const uint32_t slot = handleToSlot_[handle];
+	bodies_.layers[slot] = layer;
+	bodies_.masks[slot] = mask;
+	verlet_.Invalidate();
+}
+
+void PhysicsWorld::SetIgnoreCollision(const uint32_t handleA, const uint32_t handleB, const bool ignore) {
+	if (ignore) {
+		ignoredPairs_.Add(handleToSlot_[handleA], handleToSlot_[handleB]);
+	} else {
+		ignoredPairs_.Remove(handleToSlot_[handleA], handleToSlot_[handleB]);
+	}
+	verlet_.Invalidate();
+}
+
+void PhysicsWorld::SetTrigger(const uint32_t handle, const bool isTrigger) {
+	uint8_t& trigger = bodies_.triggers[handleToSlot_[handle]];
+	const uint8_t value = isTrigger ? 1 : 0;
+	if (trigger != value) {
+		triggerCount_ = isTrigger ? triggerCount_ + 1 : triggerCount_ - 1;
+		trigger = value;
+	}
+}
+
+float PhysicsWorld::ComputeEnergy() const {
+	return ComputeKineticEnergy() + forceGenerators_.ComputePotentialEnergy(bodies_);
+}
+
+void PhysicsWorld::IntegrateVelocities() {
+	const uint32_t count = bodies_.Size();
+	std::fill(bodies_.forces.begin(), bodies_.forces.end(), Vec3::zero);
+	forceGenerators_.Apply(bodies_);
+
+	for (uint32_t i = 0; i < count; ++i) {
+		bodies_.velocities[i] += bodies_.forces[i] * (bodies_.inverseMasses[i] * settings_.deltaTime);
+	}
+}
+
+void PhysicsWorld::SolveConstraints() {
+	PROFILE_ZONE("SolveConstraints");
+	BodyArrays& b = bodies_;
+	const uint32_t count = b.Size();
+
+	// 接触イベントを出すときだけ、ペアごとに撃力を足し合わせる
+	const bool recordContacts = settings_.contactEventThreshold >= 0.0f;
+	if (recordContacts) {
+		pairContacts_.assign(pairs_.size(), {});
+	}
+
+	// 誤差が許容値を下回るか最大反復回数に達するまで繰り返す
+	metrics_.solver = {};
+	for (uint32_t iteration = 0; iteration < settings_.maxIterations; ++iteration) {
+		const size_t pairCount = pairs_.size();
+		for (size_t k = 0; k < pairCount; ++k) {
+			const auto [i, j] = pairs_[k];
+			ContactManifold contact;
+			if (!ComputeSphereContact(b.positions[i], b.radii[i], b.positions[j], b.radii[j], contact)) {
+				continue;
+			}
+			if (iteration == 0) {
+				metrics_.maxPenetration = std::max(metrics_.maxPenetration, contact.penetration);
+			}
+
+			// めり込みは疑似速度で解消し、実際の運動量を増やさない
+			SolveContactPosition(contact, b.pseudoVelocities[i], b.inverseMasses[i], b.pseudoVelocities[j],
+				b.inverseMasses[j], settings_);
+
+			const float e = std::min(b.restitutions[i], b.restitutions[j]);
+			const float impulse = SolveContactVelocity(
+				contact, b.velocities[i], b.inverseMasses[i], b.velocities[j], b.inverseMasses[j], e);
+			if (recordContacts && impulse > 0.0f) {
+				// 接触点と法線は最後に撃力を加えた反復のもの
+				ContactEvent& record = pairContacts_[k];
+				record.point = b.positions[i] + contact.normal * (b.radii[i] - contact.penetration * 0.5f);
+				record.normal = contact.normal;
+				record.impulse += impulse;
+			}
+		}
+
+		for (uint32_t i = 0; i < count; ++i) {
+			const uint32_t parent = b.parents[i];
+			if (parent == kNoParent) {
+				continue;
+			}
+			SolveDistanceConstraint(
+				b.positions[parent], b.inverseMasses[parent], b.positions[i], b.inverseMasses[i], b.maxDistances[i]);
+		}
+
+		// 距離拘束で位置が動くので、誤差は全部解き終えてから測り直す
+		const float residual = ComputeResidual();
+		metrics_.solver.iterations = iteration + 1;
+		metrics_.solver.residual = residual;
+		if (residual < settings_.tolerance) {
+			break;
+		}
+	}
+
+	// 速度の減衰は反復回数に依存しないよう1ステップに1回だけ
+	for (uint32_t i = 0; i < count; ++i) {
+		const uint32_t parent = b.parents[i];
+		if (parent == kNoParent) {
+			continue;
+		}
+		DampDistanceConstraint(b.positions[parent], b.velocities[parent], b.inverseMasses[parent],
+			b.positions[i], b.velocities[i], b.inverseMasses[i], settings_.reductionFactor);
+	}
+}
+
+float PhysicsWorld::ComputeResidual() const {
+	const BodyArrays& b = bodies_;
+	float residual = 0.0f;
+
+	// 両方とも静的な組は解かないので数えない
+	for (const auto& [i, j] : pairs_) {
+		if (b.inverseMasses[i] + b.inverseMasses[j] <= 0.0f) {
+			continue;
+		}
+		ContactManifold contact;
+		if (ComputeSphereContact(b.positions[i], b.radii[i], b.positions[j], b.radii[j], contact)) {
+			residual = std::max(residual, ComputeContactPositionError(
+				contact, b.pseudoVelocities[i], b.pseudoVelocities[j], settings_));
+		}
+	}
+
+	const uint32_t count = b.Size();
+	for (uint32_t i = 0; i < count; ++i) {
+		const uint32_t parent = b.parents[i];
+		if (parent == kNoParent || b.inverseMasses[parent] + b.inverseMasses[i] <= 0.0f) {
+			continue;
+		}
+		const float distance = b.positions[parent].Distance(b.positions[i]);
+		residual = std::max(residual, distance - b.maxDistances[i]);
+	}
+
+	return residual;
+}
+
+void PhysicsWorld::IntegratePositions() {
+	const uint32_t count = bodies_.Size();
+	for (uint32_t i = 0; i < count; ++i) {
+		// 疑似速度は位置の補正にだけ使い、次のステップには持ち越さない
+		bodies_.positions[i] += (bodies_.velocities[i] + bodies_.pseudoVelocities[i]) * settings_.deltaTime;
+		bodies_.pseudoVelocities[i] = Vec3::zero;
+	}
+}
+
+CollisionFilter PhysicsWorld::MakeCollisionFilter() const {
+	CollisionFilter filter;
+	filter.layers = bodies_.layers;
+	filter.masks = bodies_.masks;
+	if (!settings_.parentCollision) {
+		filter.parents = bodies_.parents;
+	}
+	filter.ignoredPairs = &ignoredPairs_;
+	return filter;
+}
+
+void PhysicsWorld::UpdateTriggers() {
+	PROFILE_ZONE("UpdateTriggers");
+
+	previousTriggerPairs_.swap(triggerPairs_);
+	triggerPairs_.clear();
+	triggerEvents_.clear();
+	metrics_.triggerPairCount = 0;
+	// トリガーがなく、前のステップの組もなければ出すイベントもない
+	if (triggerCount_ == 0 && previousTriggerPairs_.empty()) {
+		return;
+	}
+
+	// トリガーの組をハンドルで抜き出し、残りを前に詰める
+	const uint8_t* triggers = bodies_.triggers.data();
+	size_t contactCount = 0;
+	for (const BodyPair& pair : pairs_) {
+		if (triggers[pair.a] | triggers[pair.b]) {
+			const uint32_t handleA = slotToHandle_[pair.a];
+			const uint32_t handleB = slotToHandle_[pair.b];
+			triggerPairs_.push_back(
+				(static_cast<uint64_t>(std::min(handleA, handleB)) << 32) | std::max(handleA, handleB));
+		} else {
+			pairs_[contactCount++] = pair;
+		}
+	}
+	pairs_.resize(contactCount);
+	metrics_.triggerPairCount = static_cast<uint32_t>(triggerPairs_.size());
+
+	// ソート済みの組どうしを突き合わせると、片方にしかない組が出入りした組になる
+	std::sort(triggerPairs_.begin(), triggerPairs_.end());
+	const auto Emit = [&](const TriggerEventType type, const uint64_t key) {
+		const uint32_t handleA = static_cast<uint32_t>(key >> 32);
+		const uint32_t handleB = static_cast<uint32_t>(key);
+		const bool aIsTrigger = triggers[handleToSlot_[handleA]] != 0;
+		// トリガーを外した剛体の離脱ではどちらもトリガーでないので、そのときはaをトリガーとして出す
+		if (aIsTrigger || triggers[handleToSlot_[handleB]] == 0) {
+			triggerEvents_.push_back({type, handleA, handleB});
+		} else {
+			triggerEvents_.push_back({type, handleB, handleA});
+		}
+	};
+
+	auto previous = previousTriggerPairs_.begin();
+	auto current = triggerPairs_.begin();
+	while (previous != previousTriggerPairs_.end() || current != triggerPairs_.end()) {
+		if (current == triggerPairs_.end() || (previous != previousTriggerPairs_.end() && *previous < *current)) {
+			Emit(TriggerEventType::Exit, *previous++);
+		} else if (previous == previousTriggerPairs_.end() || *current < *previous) {
+			Emit(TriggerEventType::Enter, *current++);
+		} else {
+			Emit(TriggerEventType::Stay, *current);
+			++previous;
+			++current;
+		}
+	}
+}
+
+void PhysicsWorld::EmitContactEvents() {
+	PROFILE_ZONE("EmitContactEvents");
+
+	const float threshold = settings_.contactEventThreshold;
+	if (threshold < 0.0f) {
+		contactEvents_.Reset(0);
+		metrics_.contactEventCount = 0;
+		return;
+	}
+
+	// 全部のペアが通っても溢れない容量にしておく
+	// 撃力はソルバーが出し終えているので、ペアの順に1回なめて書き出せば順番も毎回同じになる
+	const uint32_t pairCount = static_cast<uint32_t>(pairs_.size());
+	contactEvents_.Reset(pairCount);
+	for (uint32_t k = 0; k < pairCount; ++k) {
+		const ContactEvent& record = pairContacts_[k];
+		// 撃力が0の組 (離れようとしていた・重ならなかった) は閾値が0でも出さない
+		if (record.impulse <= 0.0f || record.impulse < threshold) {
+			continue;
+		}
+		ContactEvent event = record;
+		event.a = slotToHandle_[pairs_[k].a];
+		event.b = slotToHandle_[pairs_[k].b];
+		contactEvents_.Push(event);
+	}
+	metrics_.contactEventCount = static_cast<uint32_t>(contactEvents_.GetEvents().size());
+}
+
+template <typename T>
+void PhysicsWorld::Permute(std::vector<T>& values, std::vector<T>& scratch, ThreadPool* pool) const {
+	const std::span<const uint32_t> order = mortonSort_.GetOrder();
+	const uint32_t count = static_cast<uint32_t>(values.size());
+	scratch.resize(count);
+
+	const auto Gather = [&](const uint32_t begin, const uint32_t end) {
+		for (uint32_t i = begin; i < end; ++i) {
+			scratch[i] = values[order[i]];
+		}
+	};
+	if (pool != nullptr && count >= kReorderParallelThreshold) {
+		pool->ParallelFor(count, kReorderGrainSize, Gather);
+	} else {
+		Gather(0, count);
+	}
+
+	values.swap(scratch);
+}
+
+float PhysicsWorld::ComputeKineticEnergy() const {
+	float energy = 0.0f;
+	for (uint32_t i = 0; i < bodies_.Size(); ++i) {
+		if (bodies_.inverseMasses[i] > 0.0f) {
+			energy += 0.5f * bodies_.masses[i] * bodies_.velocities[i].SqrtLength();
+		}
+	}
+	return energy;
+}
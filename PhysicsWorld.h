@@ -0,0 +1,240 @@
+#pragma once
+#include <vector>
+
+#include "BodyArrays.h"
+#include "CollisionFilter.h"
+#include "ContactEventBuffer.h"
+#include "ForceGenerator.h"
+#include "LinearBvh.h"
+#include "MortonSort.h"
+#include "SceneDescription.h"
+#include "Solver.h"
+#include "SpatialGrid.h"
+#include "VerletList.h"
+
+class ThreadPool;
+
+/// <summary>
+/// 1ステップ分の計測値
+/// </summary>
+struct StepMetrics {
+	SolverStats solver;
+	uint32_t pairCount = 0; // ブロードフェーズが出したペア数
+	uint32_t triggerPairCount = 0; // そのうちトリガーが関わり、ソルバーに渡さなかったペア数
+	uint32_t contactEventCount = 0; // 撃力が閾値以上で通知した接触の数
+	float maxPenetration = 0.0f; // 解く前の最大めり込み深度
+	float kineticEnergy = 0.0f;
+	float potentialEnergy = 0.0f;
+	double stepMilliseconds = 0.0;
+};
+
+/// <summary>
+/// トリガーとの重なりの変化の種類
+/// </summary>
+enum class TriggerEventType : uint8_t {
+	Enter, // このステップで重なり始めた
+	Stay, // 前のステップから重なり続けている
+	Exit, // このステップで離れた
+};
+
+/// <summary>
+/// トリガーとの重なりの通知
+/// 剛体はハンドルで指すので、並べ替えをまたいでも同じ剛体を指します
+/// </summary>
+struct TriggerEvent {
+	TriggerEventType type;
+	uint32_t trigger; // トリガーの剛体 (両方トリガーならハンドルの小さい方)
+	uint32_t other; // 重なった相手
+};
+
+/// <summary>
+/// 描画に依存しない物理ワールド
+/// 剛体をSoAで持ち、力の計算・衝突・距離拘束・積分を行います
+/// 剛体は定期的に位置のモートン順へ並べ替えるので、BodyArraysの添字 (スロット) は変わることがあります
+/// 外から剛体を指すときはLoadした順の番号 (ハンドル) を使い、GetBodySlotでスロットに直します
+/// </summary>
+class PhysicsWorld {
+public:
+	/// <summary>
+	/// シーンの記述から剛体とフォースを作り直します
+	/// フォースには重力 (gravities[0]) と速度比例の抵抗 (linearDrags[0]) が必ず入ります
+	/// </summary>
+	void Load(const SceneDescription& scene);
+
+	/// <summary>
+	/// settings.deltaTime だけ進めます
+	/// settings.reorderIntervalステップごとに剛体を並べ替えます
+	/// </summary>
+	/// <param name="pool">渡すとLBVHの構築・ペア探索と並べ替えをスレッドへ分けます</param>
+	void Step(ThreadPool* pool = nullptr);
+
+	/// <summary>
+	/// 剛体を位置のモートン順に並べ替え、近い剛体がメモリ上でも近くなるようにします
+	/// 親の添字・バネの両端・ハンドルの対応も付け替えます
+	/// 範囲や添字リストを対象にするフォースがあるときは何もしません
+	/// </summary>
+	/// <returns>並べ替えたらtrue</returns>
+	bool ReorderBodies(ThreadPool* pool = nullptr);
+
+	/// <summary>
+	/// 運動エネルギーと位置エネルギーの和
+	/// </summary>
+	float ComputeEnergy() const;
+
+	BodyArrays& GetBodies() {
+		return bodies_;
+	}
+
+	const BodyArrays& GetBodies() const {
+		return bodies_;
+	}
+
+	/// <summary>
+	/// ハンドル (Loadしたときの剛体の番号) から今のスロット (BodyArraysの添字)
+	/// </summary>
+	uint32_t GetBodySlot(const uint32_t handle) const {
+		return handleToSlot_[handle];
+	}
+
+	/// <summary>
+	/// スロットにある剛体のハンドル
+	/// </summary>
+	uint32_t GetBodyHandle(const uint32_t slot) const {
+		return slotToHandle_[slot];
+	}
+
+	/// <summary>
+	/// 剛体の衝突レイヤーとマスクを設定します
+	/// 互いのレイヤーが相手のマスクに含まれる組だけがブロードフェーズを通ります
+	/// </summary>
+	void SetCollisionLayer(uint32_t handle, uint32_t layer, uint32_t mask);
+
+	/// <summary>
+	/// 2つの剛体の組を衝突させないか設定します
+	/// </summary>
+	void SetIgnoreCollision(uint32_t handleA, uint32_t handleB, bool ignore = true);
+
+	/// <summary>
+	/// 剛体をトリガーにするか設定します
+	/// トリガーはブロードフェーズで重なりを調べるだけで、接触としては解きません
+	/// </summary>
+	void SetTrigger(uint32_t handle, bool isTrigger);
+
+	/// <summary>
+	/// 直前のStepでのトリガーの重なりの変化 (組のハンドル順)
+	/// ソルバーの中からは何も呼ばないので、Stepの後にこの配列を読んでください
+	/// </summary>
+	std::span<const TriggerEvent> GetTriggerEvents() const {
+		return triggerEvents_;
+	}
+
+	/// <summary>
+	/// 直前のStepで撃力がsettings.contactEventThreshold以上だった接触
+	/// 撃力は反復で加えた分の合計で、ソルバーの中からは何も呼びません
+	/// 並びはブロードフェーズのペアの順で、poolの有無によらず毎回同じです
+	/// </summary>
+	std::span<const ContactEvent> GetContactEvents() const {
+		return contactEvents_.GetEvents();
+	}
+
+	SolverSettings& GetSettings() {
+		return settings_;
+	}
+
+	ForceGeneratorSet& GetForceGenerators() {
+		return forceGenerators_;
+	}
+
+	SpatialGrid& GetSpatialGrid() {
+		return grid_;
+	}
+
+	LinearBvh& GetLinearBvh() {
+		return bvh_;
+	}
+
+	const VerletList& GetVerletList() const {
+		return verlet_;
+	}
+
+	const StepMetrics& GetMetrics() const {
+		return metrics_;
+	}
+
+private:
+	void IntegrateVelocities();
+	void SolveConstraints();
+	void IntegratePositions();
+	float ComputeKineticEnergy() const;
+
+	/// <summary>
+	/// 反復を終えた時点で残っている誤差の最大 (長さ)
+	/// 接触は疑似速度で動いたあとのめり込み、距離拘束は最大距離の超過
+	/// </summary>
+	float ComputeResidual() const;
+
+	/// <summary>
+	/// 今の設定でのブロードフェーズのふるい分け
+	/// </summary>
+	CollisionFilter MakeCollisionFilter() const;
+
+	/// <summary>
+	/// トリガーが関わるペアをpairs_から抜き出し、前のステップの組と比べてイベントを作ります
+	/// </summary>
+	void UpdateTriggers();
+
+	/// <summary>
+	/// SolveConstraintsで記録したペアごとの撃力から、閾値以上のものをペアの順にcontactEvents_へ書き出します
+	/// </summary>
+	void EmitContactEvents();
+
+	/// <summary>
+	/// valuesをmortonSort_の順に並べ替えます (scratchは作業用)
+	/// </summary>
+	template <typename T>
+	void Permute(std::vector<T>& values, std::vector<T>& scratch, ThreadPool* pool) const;
+
+	BodyArrays bodies_;
+	SolverSettings settings_;
+	ForceGeneratorSet forceGenerators_;
+
+	// settings.broadphaseで選んだ方だけを毎ステップ作り直す
+	SpatialGrid grid_;
+	LinearBvh bvh_;
+	VerletList verlet_;
+	std::vector<BodyPair> pairs_;
+
+	// 衝突させない組 (スロットで持ち、並べ替えで付け替える)
+	IgnoredPairSet ignoredPairs_;
+	// 近傍リストを作ったときのsettings.parentCollision (変わったら作り直す)
+	bool verletParentCollision_ = true;
+
+	// トリガー
+	uint32_t triggerCount_ = 0;
+	// トリガーが関わる組 (ハンドルの小さい方を上位32bitに詰めた値の昇順)
+	std::vector<uint64_t> triggerPairs_;
+	std::vector<uint64_t> previousTriggerPairs_;
+	std::vector<TriggerEvent> triggerEvents_;
+
+	// 接触イベント
+	// ペアごとの接触点・法線・撃力の合計 (pairs_と同じ並び、ハンドルは書き出すときに入れる)
+	std::vector<ContactEvent> pairContacts_;
+	ContactEventBuffer contactEvents_;
+
+	StepMetrics metrics_;
+
+	// ハンドルとスロットの対応
+	std::vector<uint32_t> handleToSlot_;
+	std::vector<uint32_t> slotToHandle_;
+
+	// 並べ替え
+	MortonSort mortonSort_;
+	uint32_t stepsSinceReorder_ = 0;
+	// 元のスロットから新しいスロットへの表
+	std::vector<uint32_t> newSlots_;
+	// 並べ替えの作業用 (確保し直さないよう使い回す)
+	std::vector<Vec3> vec3Scratch_;
+	std::vector<float> floatScratch_;
+	std::vector<uint32_t> indexScratch_;
+	std::vector<uint8_t> byteScratch_;
+};
@@ -0,0 +1,137 @@
+#include "Profiler.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+
+namespace {
+	uint64_t SteadyNanoseconds() {
+		const auto now = std::chrono::steady_clock::now().time_since_epoch();
+		return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(now).count());
+	}
+}
+
+void ProfileThreadBuffer::Snapshot(const uint64_t begin, const uint64_t end, std::vector<ProfileEvent>& outEvents,
+	std::vector<uint64_t>& scratchIndices) const {
+	const uint64_t written = written_.load(std::memory_order_acquire);
+	const uint64_t first = written > kCapacity ? written - kCapacity : 0;
+
+	const size_t start = outEvents.size();
+	scratchIndices.clear();
+	for (uint64_t i = first; i < written; ++i) {
+		const ProfileEvent& event = events_[i & (kCapacity - 1)];
+		if (event.end > begin && event.begin < end) {
+			outEvents.push_back(event);
+			scratchIndices.push_back(i);
+		}
+	}
+
+	// 写している間に書き手が一周して上書きしたかもしれない区間は捨てる
+	// 添字iのスロットは written_ が i + kCapacity になった時点から書き換わりうる
+	const uint64_t after = written_.load(std::memory_order_acquire);
+	if (after >= first + kCapacity) {
+		const uint64_t safeFirst = after - kCapacity + 1;
+		size_t keep = start;
+		for (size_t k = 0; k < scratchIndices.size(); ++k) {
+			if (scratchIndices[k] >= safeFirst) {
+				outEvents[keep++] = outEvents[start + k];
+			}
+		}
+		outEvents.resize(keep);
+	}
+}
+
+Profiler::Profiler() : epoch_(SteadyNanoseconds()) {}
+
+Profiler* Profiler::GetInstance() {
+	static Profiler instance;
+	return &instance;
+}
+
+ProfileThreadBuffer& Profiler::GetThreadBuffer() {
+	thread_local ProfileThreadBuffer* buffer = nullptr;
+	if (buffer == nullptr) {
+		// バッファはプロファイラが持ち、スレッドが終わっても区間を読めるようにする
+		std::lock_guard lock(registryMutex_);
+		buffers_.push_back(std::make_unique<ProfileThreadBuffer>(static_cast<uint32_t>(buffers_.size())));
+		buffer = buffers_.back().get();
+	}
+	return *buffer;
+}
+
+uint64_t Profiler::Now() const {
+	return SteadyNanoseconds() - epoch_;
+}
+
+void Profiler::NewFrame() {
+	const uint64_t now = Now();
+	const uint64_t begin = frameBegin_.exchange(now, std::memory_order_relaxed);
+	if (begin != 0) {
+		lastFrameBegin_.store(begin, std::memory_order_relaxed);
+		lastFrameEnd_.store(now, std::memory_order_release);
+		frameHistory_[frameCount_ % kFrameHistory] = static_cast<float>(static_cast<double>(now - begin) * 1.0e-6);
+		++frameCount_;
+	}
+}
+
+std::pair<uint64_t, uint64_t> Profiler::CollectLastFrame(std::vector<ProfileThreadEvents>& outThreads) const {
+	const uint64_t end = lastFrameEnd_.load(std::memory_order_acquire);
+	const uint64_t begin = lastFrameBegin_.load(std::memory_order_relaxed);
+	Collect(begin, end, outThreads);
+	return {begin, end};
+}
+
+bool Profiler::ExportChromeTrace(const std::string& path) const {
+	std::vector<ProfileThreadEvents> threads;
+	Collect(0, UINT64_MAX, threads);
+
+	FILE* file = std::fopen(path.c_str(), "w");
+	if (file == nullptr) {
+		return false;
+	}
+
+	// 完了イベント ("ph":"X") としてマイクロ秒単位で書き出す
+	std::fprintf(file, "{\"traceEvents\":[\n");
+	bool first = true;
+	for (const ProfileThreadEvents& thread : threads) {
+		std::fprintf(file, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":%u,\"args\":{\"name\":\"%s %u\"}}",
+			first ? "" : ",\n", thread.threadIndex, thread.threadIndex == 0 ? "Main" : "Thread", thread.threadIndex);
+		first = false;
+
+		for (const ProfileEvent& event : thread.events) {
+			std::fprintf(file, ",\n{\"name\":\"%s\",\"ph\":\"X\",\"pid\":0,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f}",
+				event.name, thread.threadIndex, static_cast<double>(event.begin) * 1.0e-3,
+				static_cast<double>(event.end - event.begin) * 1.0e-3);
+		}
+	}
+	std::fprintf(file, "\n],\"displayTimeUnit\":\"ms\"}\n");
+
+	return std::fclose(file) == 0;
+}
+
+void Profiler::GetFrameHistory(std::vector<float>& outMilliseconds) const {
+	outMilliseconds.clear();
+	const uint32_t count = std::min(frameCount_, kFrameHistory);
+	for (uint32_t i = frameCount_ - count; i < frameCount_; ++i) {
+		outMilliseconds.push_back(frameHistory_[i % kFrameHistory]);
+	}
+}
+
+void Profiler::Collect(const uint64_t begin, const uint64_t end, std::vector<ProfileThreadEvents>& outThreads) const {
+	std::lock_guard lock(registryMutex_);
+
+	// 毎フレーム呼ばれるので、スレッドごとの配列は作り直さず中身だけ入れ替える
+	outThreads.resize(buffers_.size());
+	for (size_t t = 0; t < buffers_.size(); ++t) {
+		const ProfileThreadBuffer& buffer = *buffers_[t];
+		ProfileThreadEvents& thread = outThreads[t];
+		thread.threadIndex = buffer.GetThreadIndex();
+		thread.events.clear();
+		buffer.Snapshot(begin, end, thread.events, snapshotIndices_);
+
+		// 入れ子の外側が先に来るよう開始時刻順に並べる
+		std::sort(thread.events.begin(), thread.events.end(), [](const ProfileEvent& a, const ProfileEvent& b) {
+			return a.begin < b.begin || (a.begin == b.begin && a.depth < b.depth);
+		});
+	}
+}
@@ -0,0 +1,165 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// ENABLE_PROFILER が定義されていないときは計測マクロが何も生成しません
+#ifdef ENABLE_PROFILER
+#define PROFILE_CONCAT_INNER(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_INNER(a, b)
+// スコープの終わりまでを名前つきの区間として記録する (nameは文字列リテラル)
+#define PROFILE_ZONE(name) const ProfileZone PROFILE_CONCAT(profileZone_, __LINE__)(name)
+// フレームの区切り (メインループの先頭で呼ぶ)
+#define PROFILE_FRAME() Profiler::GetInstance()->NewFrame()
+#else
+#define PROFILE_ZONE(name) ((void)0)
+#define PROFILE_FRAME() ((void)0)
+#endif
+
+/// <summary>
+/// 記録された1区間
+/// </summary>
+struct ProfileEvent {
+	const char* name = nullptr;
+	uint64_t begin = 0; // プロファイラ起動からのナノ秒
+	uint64_t end = 0;
+	uint32_t depth = 0; // 入れ子の深さ (0が一番外側)
+};
+
+/// <summary>
+/// スレッドごとのリングバッファ
+/// 書き込みは所有スレッドだけが行い、読み出し側はロックせずに最新の区間を写し取ります
+/// </summary>
+class ProfileThreadBuffer {
+public:
+	static constexpr uint32_t kCapacity = 1 << 14;
+
+	explicit ProfileThreadBuffer(const uint32_t threadIndex) : threadIndex_(threadIndex) {}
+
+	/// <summary>
+	/// 区間を追加します (所有スレッドからのみ)
+	/// </summary>
+	void Push(const ProfileEvent& event) {
+		const uint64_t written = written_.load(std::memory_order_relaxed);
+		events_[written & (kCapacity - 1)] = event;
+		written_.store(written + 1, std::memory_order_release);
+	}
+
+	/// <summary>
+	/// [begin, end) と重なる区間を古い順に写し取ります
+	/// 読んでいる間に上書きされた可能性のある区間は捨てます
+	/// </summary>
+	/// <param name="scratchIndices">作業用 (呼び出し側で使い回し、毎回確保しないようにする)</param>
+	void Snapshot(uint64_t begin, uint64_t end, std::vector<ProfileEvent>& outEvents,
+		std::vector<uint64_t>& scratchIndices) const;
+
+	uint32_t GetThreadIndex() const {
+		return threadIndex_;
+	}
+
+	// 所有スレッドの現在の入れ子の深さ
+	uint32_t depth = 0;
+
+private:
+	std::array<ProfileEvent, kCapacity> events_;
+	std::atomic<uint64_t> written_ = 0;
+	uint32_t threadIndex_;
+};
+
+/// <summary>
+/// スレッド1つ分の区間
+/// </summary>
+struct ProfileThreadEvents {
+	uint32_t threadIndex = 0;
+	std::vector<ProfileEvent> events;
+};
+
+/// <summary>
+/// スコープ計測のプロファイラ
+/// </summary>
+class Profiler {
+public:
+	static constexpr uint32_t kFrameHistory = 240;
+
+	static Profiler* GetInstance();
+
+	/// <summary>
+	/// 呼び出し元スレッドのバッファ (初回だけ登録のためにロックします)
+	/// </summary>
+	ProfileThreadBuffer& GetThreadBuffer();
+
+	/// <summary>
+	/// プロファイラ起動からの経過時間 (ナノ秒)
+	/// </summary>
+	uint64_t Now() const;
+
+	/// <summary>
+	/// フレームの区切りを記録します
+	/// </summary>
+	void NewFrame();
+
+	/// <summary>
+	/// 直前に終わったフレームの全スレッドの区間を集めます
+	/// </summary>
+	/// <returns>フレームの開始と終了 (ナノ秒)</returns>
+	std::pair<uint64_t, uint64_t> CollectLastFrame(std::vector<ProfileThreadEvents>& outThreads) const;
+
+	/// <summary>
+	/// バッファに残っているすべての区間をChromeのトレース形式 (JSON) で書き出します
+	/// chrome://tracing や Perfetto で開けます
+	/// </summary>
+	bool ExportChromeTrace(const std::string& path) const;
+
+	/// <summary>
+	/// 最近のフレーム時間 (ミリ秒、古い順)
+	/// </summary>
+	void GetFrameHistory(std::vector<float>& outMilliseconds) const;
+
+private:
+	Profiler();
+
+	void Collect(uint64_t begin, uint64_t end, std::vector<ProfileThreadEvents>& outThreads) const;
+
+	mutable std::mutex registryMutex_;
+	std::vector<std::unique_ptr<ProfileThreadBuffer>> buffers_;
+	// Snapshotの作業用 (registryMutex_で守る)
+	mutable std::vector<uint64_t> snapshotIndices_;
+
+	uint64_t epoch_ = 0;
+
+	// NewFrameはメインスレッドから呼ぶ。読み出しは別スレッドからもありうる
+	std::atomic<uint64_t> frameBegin_ = 0;
+	std::atomic<uint64_t> lastFrameBegin_ = 0;
+	std::atomic<uint64_t> lastFrameEnd_ = 0;
+
+	std::array<float, kFrameHistory> frameHistory_ = {};
+	uint32_t frameCount_ = 0;
+};
+
+/// <summary>
+/// 生成から破棄までを1区間として記録します
+/// PROFILE_ZONE マクロから使います
+/// </summary>
+class ProfileZone {
+public:
+	explicit ProfileZone(const char* name) : buffer_(Profiler::GetInstance()->GetThreadBuffer()), name_(name),
+		depth_(buffer_.depth++), begin_(Profiler::GetInstance()->Now()) {}
+
+	~ProfileZone() {
+		buffer_.Push({name_, begin_, Profiler::GetInstance()->Now(), depth_});
+		--buffer_.depth;
+	}
+
+	ProfileZone(const ProfileZone&) = delete;
+	ProfileZone& operator=(const ProfileZone&) = delete;
+
+private:
+	ProfileThreadBuffer& buffer_;
+	const char* name_;
+	uint32_t depth_;
+	uint64_t begin_;
+};
@@ -0,0 +1,114 @@
+#include "ProfilerOverlay.h"
+
+#include <algorithm>
+#include <imgui.h>
+#include <string>
+#include <vector>
+
+#include "AllocationTracker.h"
+#include "Profiler.h"
+
+#ifdef ENABLE_PROFILER
+namespace {
+	// 名前から色を決め、同じ区間は毎フレーム同じ色にする
+	ImU32 ZoneColor(const char* name) {
+		uint32_t hash = 2166136261u;
+		for (const char* c = name; *c != '\0'; ++c) {
+			hash = (hash ^ static_cast<uint8_t>(*c)) * 16777619u;
+		}
+		return IM_COL32(80 + hash % 150, 80 + (hash >> 8) % 150, 80 + (hash >> 16) % 150, 255);
+	}
+}
+#endif
+
+void DrawProfilerOverlay() {
+	ImGui::Begin("Profiler");
+
+#ifdef ENABLE_ALLOCATION_TRACKING
+	// 直前のフレームのフェーズごとのヒープ確保
+	if (ImGui::CollapsingHeader("Allocations", ImGuiTreeNodeFlags_DefaultOpen)) {
+		const AllocationTracker* tracker = AllocationTracker::GetInstance();
+		for (uint32_t i = 0; i < tracker->GetPhaseCount(); ++i) {
+			const AllocationTracker::Phase& phase = tracker->GetPhases()[i];
+			ImGui::Text("%-24s %6llu allocs %10llu bytes", phase.name,
+				static_cast<unsigned long long>(phase.last.count), static_cast<unsigned long long>(phase.last.bytes));
+		}
+	}
+#endif
+
+#ifdef ENABLE_PROFILER
+	Profiler* profiler = Profiler::GetInstance();
+
+	static std::vector<float> history;
+	profiler->GetFrameHistory(history);
+	if (!history.empty()) {
+		ImGui::PlotLines("Frame ms", history.data(), static_cast<int>(history.size()), 0,
+			nullptr, 0.0f, 33.3f, ImVec2(0.0f, 60.0f));
+	}
+
+	static char tracePath[128] = "profile.json";
+	ImGui::InputText("##TracePath", tracePath, sizeof(tracePath));
+	ImGui::SameLine();
+	if (ImGui::Button("Export Trace")) {
+		profiler->ExportChromeTrace(tracePath);
+	}
+
+	static std::vector<ProfileThreadEvents> threads;
+	const auto [frameBegin, frameEnd] = profiler->CollectLastFrame(threads);
+	if (frameEnd <= frameBegin) {
+		ImGui::End();
+		return;
+	}
+
+	const double frameNanoseconds = static_cast<double>(frameEnd - frameBegin);
+	ImGui::Text("Last frame: %.3f ms", frameNanoseconds * 1.0e-6);
+
+	// 横軸を時間、縦を入れ子の深さにしたフレームグラフ
+	constexpr float kRowHeight = 18.0f;
+	const float width = ImGui::GetContentRegionAvail().x;
+	ImDrawList* drawList = ImGui::GetWindowDrawList();
+
+	for (const ProfileThreadEvents& thread : threads) {
+		uint32_t maxDepth = 0;
+		for (const ProfileEvent& event : thread.events) {
+			maxDepth = std::max(maxDepth, event.depth);
+		}
+		if (thread.events.empty()) {
+			continue;
+		}
+
+		ImGui::Text("Thread %u", thread.threadIndex);
+		const ImVec2 origin = ImGui::GetCursorScreenPos();
+		const float height = kRowHeight * static_cast<float>(maxDepth + 1);
+		ImGui::InvisibleButton(("##Thread" + std::to_string(thread.threadIndex)).c_str(), ImVec2(width, height));
+		const ImVec2 mouse = ImGui::GetIO().MousePos;
+
+		for (const ProfileEvent& event : thread.events) {
+			const double begin = static_cast<double>(std::max(event.begin, frameBegin) - frameBegin);
+			const double end = static_cast<double>(std::min(event.end, frameEnd) - frameBegin);
+			const ImVec2 min = {
+				origin.x + static_cast<float>(begin / frameNanoseconds) * width,
+				origin.y + kRowHeight * static_cast<float>(event.depth)
+			};
+			const ImVec2 max = {
+				std::max(origin.x + static_cast<float>(end / frameNanoseconds) * width, min.x + 1.0f),
+				min.y + kRowHeight - 1.0f
+			};
+
+			drawList->AddRectFilled(min, max, ZoneColor(event.name));
+			// 幅が足りるときだけ名前を描く
+			if (max.x - min.x > ImGui::CalcTextSize(event.name).x + 4.0f) {
+				drawList->AddText(ImVec2(min.x + 2.0f, min.y + 1.0f), IM_COL32_BLACK, event.name);
+			}
+
+			if (mouse.x >= min.x && mouse.x < max.x && mouse.y >= min.y && mouse.y < max.y) {
+				ImGui::SetTooltip("%s\n%.3f ms", event.name, static_cast<double>(event.end - event.begin) * 1.0e-6);
+			}
+		}
+	}
+#else
+	ImGui::Text("Profiler is disabled (define ENABLE_PROFILER)");
+#endif
+
+	ImGui::End();
+}
@@ -0,0 +1,7 @@
+#pragma once
+
+/// <summary>
+/// プロファイラのImGuiウィンドウを描画します
+/// フレーム時間のグラフと、直前のフレームのスレッドごとのタイムラインを表示します
+/// </summary>
+void DrawProfilerOverlay();
@@ -0,0 +1,124 @@
+#pragma once
+#include <cmath>
+
+#include "Vec3.h"
+
+/// <summary>
+/// 回転を表す単位クォータニオン
+/// 行列への変換は積と和だけで済むので、毎フレームの計算では三角関数を使いません
+/// オイラー角との変換はエディタなどの編集の境目だけで行います
+/// </summary>
+struct Quaternion final {
+	float x, y, z, w;
+
+	constexpr Quaternion() : x(0.0f), y(0.0f), z(0.0f), w(1.0f) {}
+
+	constexpr Quaternion(const float x, const float y, const float z, const float w) : x(x), y(y), z(z), w(w) {}
+
+	static constexpr Quaternion Identity() {
+		return {};
+	}
+
+	/// <summary>
+	/// axis (正規化済み) 周りにradianだけ回す回転
+	/// </summary>
+	static Quaternion AxisAngle(const Vec3& axis, const float radian) {
+		const float s = std::sin(radian * 0.5f);
+		return {axis.x * s, axis.y * s, axis.z * s, std::cos(radian * 0.5f)};
+	}
+
+	/// <summary>
+	/// オイラー角から作ります
+	/// Mat4::Affineと同じく X, Y, Z の順に回す回転です
+	/// </summary>
+	static Quaternion FromEuler(const Vec3& euler) {
+		const float sx = std::sin(euler.x * 0.5f);
+		const float cx = std::cos(euler.x * 0.5f);
+		const float sy = std::sin(euler.y * 0.5f);
+		const float cy = std::cos(euler.y * 0.5f);
+		const float sz = std::sin(euler.z * 0.5f);
+		const float cz = std::cos(euler.z * 0.5f);
+
+		// qz * qy * qx を展開した式
+		return {
+			sx * cy * cz - cx * sy * sz,
+			cx * sy * cz + sx * cy * sz,
+			cx * cy * sz - sx * sy * cz,
+			cx * cy * cz + sx * sy * sz
+		};
+	}
+
+	/// <summary>
+	/// X, Y, Z の順に回すオイラー角に戻します
+	/// Yが±90度のときはZを0とみなします
+	/// </summary>
+	Vec3 ToEuler() const {
+		// 回転行列の要素から角度を読む (Mat4::Affineの展開式を参照)
+		const float m00 = 1.0f - 2.0f * (y * y + z * z);
+		const float m01 = 2.0f * (x * y + w * z);
+		const float m02 = 2.0f * (x * z - w * y);
+		const float m10 = 2.0f * (x * y - w * z);
+		const float m11 = 1.0f - 2.0f * (x * x + z * z);
+		const float m12 = 2.0f * (y * z + w * x);
+		const float m22 = 1.0f - 2.0f * (x * x + y * y);
+
+		const float sinY = -m02;
+		if (std::fabs(sinY) >= 0.9999999f) {
+			const float angleX = sinY > 0.0f ? std::atan2(m10, m11) : std::atan2(-m10, m11);
+			return {angleX, std::copysign(1.57079632679f, sinY), 0.0f};
+		}
+		return {std::atan2(m12, m22), std::asin(sinY), std::atan2(m01, m00)};
+	}
+
+	/* -------- メンバ関数 -------- */
+
+	constexpr float Dot(const Quaternion& other) const {
+		return x * other.x + y * other.y + z * other.z + w * other.w;
+	}
+
+	/// <summary>
+	/// 逆回転 (単位クォータニオンなら逆元)
+	/// </summary>
+	constexpr Quaternion Conjugate() const {
+		return {-x, -y, -z, w};
+	}
+
+	/// <summary>
+	/// 正規化した値を返します (長さ0なら単位元)
+	/// </summary>
+	Quaternion Normalized() const {
+		const float sqrtLength = Dot(*this);
+		if (sqrtLength > 0.0f) {
+			const float invertLength = 1.0f / std::sqrt(sqrtLength);
+			return {x * invertLength, y * invertLength, z * invertLength, w * invertLength};
+		}
+		return Identity();
+	}
+
+	/// <summary>
+	/// ベクトルを回転させます
+	/// </summary>
+	constexpr Vec3 Rotate(const Vec3& v) const {
+		// v + 2w(u×v) + 2u×(u×v)
+		const Vec3 u(x, y, z);
+		const Vec3 t = u.CrossProduct(v) * 2.0f;
+		return v + t * w + u.CrossProduct(t);
+	}
+
+	/* -------- 演算子 -------- */
+
+	/// <summary>
+	/// 回転の合成 (rhsで回してから自分で回す)
+	/// </summary>
+	constexpr Quaternion operator*(const Quaternion& rhs) const {
+		return {
+			w * rhs.x + x * rhs.w + y * rhs.z - z * rhs.y,
+			w * rhs.y - x * rhs.z + y * rhs.w + z * rhs.x,
+			w * rhs.z + x * rhs.y - y * rhs.x + z * rhs.w,
+			w * rhs.w - x * rhs.x - y * rhs.y - z * rhs.z
+		};
+	}
+
+	// 比較 (完全一致)
+	bool operator==(const Quaternion& rhs) const = default;
+};
@@ -1,31 +1,12 @@
 #pragma once
-#include "CollisionShapes.h"
-#include "Config.h"
-#include "Object.h"
-#include "Transform.h"
 #include "Vec3.h"
 
+/// <summary>
+/// 球1つ分の剛体パラメータ
+/// 積分と衝突の解決はPhysicsWorldで行います
+/// </summary>
 class Rigidbody {
 public:
-	void AddForce(const Vec3 newForce) {
-		force_ += newForce;
-	}
-
-	void Update(Object* object, CollisionShapes shapes) {
-		shapes;
-
-		AddForce({0.0f,-gravity,0.0f});
-
-		Transform parentTransform = object->GetTransform();
-
-		velocity_ += (force_ / mass_) * deltaTime;
-
-		parentTransform.position += velocity_ * deltaTime;
-
-		object->SetTransform(parentTransform.position, parentTransform.rotation, parentTransform.scale);
-		force_ = Vec3::zero;
-	}
-
 	Vec3 GetVelocity() const {
 		return velocity_;
 	}
@@ -50,6 +31,4 @@ private:
 	Vec3 velocity_; // 剛体の速度ベクトル
 	float reboundCoefficient_ = 0.25f;
 	float mass_ = 1.0f; // 剛体の重量
-
-	Vec3 force_; // 剛体に与えるフォース
 };
@@ -0,0 +1,300 @@
+#include "SceneDescription.h"
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <numbers>
+#include <random>
+#include <sstream>
+
+namespace {
+	uint32_t FindBody(const std::vector<BodyDescription>& bodies, const std::string& name) {
+		for (uint32_t i = 0; i < bodies.size(); ++i) {
+			if (bodies[i].name == name) {
+				return i;
+			}
+		}
+		return kNoParent;
+	}
+
+	// count個を収めるのに必要な立方格子の1辺の個数
+	uint32_t CubeSide(const uint32_t count) {
+		uint32_t side = static_cast<uint32_t>(std::cbrt(static_cast<double>(count)));
+		while (side * side * side < count) {
+			++side;
+		}
+		return std::max(side, 1u);
+	}
+
+	bool ReadVec3(std::istringstream& stream, Vec3& out) {
+		return static_cast<bool>(stream >> out.x >> out.y >> out.z);
+	}
+
+	bool ReadBroadphase(std::istringstream& stream, BroadphaseType& out) {
+		std::string name;
+		if (!(stream >> name)) {
+			return false;
+		}
+		for (uint32_t i = 0; i < std::size(kBroadphaseNames); ++i) {
+			if (name == kBroadphaseNames[i]) {
+				out = static_cast<BroadphaseType>(i);
+				return true;
+			}
+		}
+		return false;
+	}
+}
+
+SceneDescription SceneDescription::MakeChain(const uint32_t links) {
+	SceneDescription scene;
+
+	BodyDescription root;
+	root.name = "SphereRoot";
+	scene.bodies.push_back(root);
+
+	for (uint32_t i = 1; i <= links; ++i) {
+		BodyDescription child;
+		child.name = "child" + std::to_string(i);
+		child.position = {child.radius * 2.0f * static_cast<float>(i), 0.0f, 0.0f};
+		child.parent = static_cast<uint32_t>(scene.bodies.size() - 1);
+		scene.bodies.push_back(child);
+	}
+
+	BodyDescription other;
+	other.name = "OtherSphere";
+	other.position = {-4.0f, 0.0f, 0.0f};
+	scene.bodies.push_back(other);
+
+	return scene;
+}
+
+SceneDescription SceneDescription::MakeGas(const uint32_t count, const uint32_t seed) {
+	SceneDescription scene;
+	scene.bodies.resize(count);
+
+	// 体積分率がおよそ5%になる大きさの箱
+	constexpr float kVolumeFraction = 0.05f;
+	const float bodyVolume = 4.0f / 3.0f * std::numbers::pi_v<float>;
+	const float halfExtent = 0.5f * std::cbrt(static_cast<float>(count) * bodyVolume / kVolumeFraction);
+
+	std::mt19937 random(seed);
+	std::uniform_real_distribution<float> position(-halfExtent, halfExtent);
+	std::uniform_real_distribution<float> velocity(-1.0f, 1.0f);
+
+	for (uint32_t i = 0; i < count; ++i) {
+		BodyDescription& body = scene.bodies[i];
+		body.name = "gas" + std::to_string(i);
+		body.position = {position(random), position(random), position(random)};
+		body.velocity = {velocity(random), velocity(random), velocity(random)};
+		body.restitution = 1.0f;
+	}
+
+	return scene;
+}
+
+SceneDescription SceneDescription::MakePile(const uint32_t count, const uint32_t seed) {
+	SceneDescription scene;
+	scene.gravity = {0.0f, -9.8f, 0.0f};
+
+	// 正方形の底面に積む。1辺は高さがおよそ底面の幅になるように決める
+	const uint32_t side = CubeSide(count);
+	constexpr float kSpacing = 1.9f; // 直径より少し詰めて最初から接触させる
+
+	std::mt19937 random(seed);
+	std::uniform_real_distribution<float> jitter(-0.05f, 0.05f);
+
+	// 床として静的な球を敷き詰める
+	for (uint32_t z = 0; z < side; ++z) {
+		for (uint32_t x = 0; x < side; ++x) {
+			BodyDescription& floor = scene.bodies.emplace_back();
+			floor.name = "floor" + std::to_string(z * side + x);
+			floor.position = {static_cast<float>(x) * kSpacing, 0.0f, static_cast<float>(z) * kSpacing};
+			floor.isStatic = true;
+		}
+	}
+
+	for (uint32_t i = 0; i < count; ++i) {
+		const uint32_t x = i % side;
+		const uint32_t z = (i / side) % side;
+		const uint32_t y = i / (side * side) + 1;
+
+		BodyDescription& body = scene.bodies.emplace_back();
+		body.name = "pile" + std::to_string(i);
+		body.position = {
+			static_cast<float>(x) * kSpacing + jitter(random),
+			static_cast<float>(y) * kSpacing,
+			static_cast<float>(z) * kSpacing + jitter(random)
+		};
+	}
+
+	return scene;
+}
+
+SceneDescription SceneDescription::MakeLattice(const uint32_t count) {
+	SceneDescription scene;
+	scene.bodies.resize(count);
+
+	const uint32_t side = CubeSide(count);
+	for (uint32_t i = 0; i < count; ++i) {
+		BodyDescription& body = scene.bodies[i];
+		body.name = "lattice" + std::to_string(i);
+		body.position = {
+			static_cast<float>(i % side) * body.radius * 2.0f,
+			static_cast<float>((i / side) % side) * body.radius * 2.0f,
+			static_cast<float>(i / (side * side)) * body.radius * 2.0f
+		};
+	}
+
+	return scene;
+}
+
+bool SceneDescription::LoadFromFile(const std::string& path, SceneDescription& outScene, std::string& outError) {
+	std::ifstream file(path);
+	if (!file) {
+		outError = path + ": cannot open";
+		return false;
+	}
+
+	SceneDescription scene;
+	std::string line;
+	uint32_t lineNumber = 0;
+
+	while (std::getline(file, line)) {
+		++lineNumber;
+		const auto Fail = [&](const std::string& reason) {
+			outError = path + ":" + std::to_string(lineNumber) + ": " + reason;
+			return false;
+		};
+
+		std::istringstream stream(line);
+		std::string key;
+		// 空行とコメント行は読み飛ばす
+		if (!(stream >> key) || key.front() == '#') {
+			continue;
+		}
+
+		bool ok = true;
+		if (key == "body") {
+			BodyDescription& body = scene.bodies.emplace_back();
+			ok = static_cast<bool>(stream >> body.name);
+		} else if (key == "deltaTime") {
+			ok = static_cast<bool>(stream >> scene.settings.deltaTime) && scene.settings.deltaTime > 0.0f;
+		} else if (key == "penetrationSlop") {
+			ok = static_cast<bool>(stream >> scene.settings.penetrationSlop);
+		} else if (key == "baumgarteFactor") {
+			ok = static_cast<bool>(stream >> scene.settings.baumgarteFactor);
+		} else if (key == "reductionFactor") {
+			ok = static_cast<bool>(stream >> scene.settings.reductionFactor);
+		} else if (key == "maxIterations") {
+			ok = static_cast<bool>(stream >> scene.settings.maxIterations);
+		} else if (key == "tolerance") {
+			ok = static_cast<bool>(stream >> scene.settings.tolerance);
+		} else if (key == "reorderInterval") {
+			ok = static_cast<bool>(stream >> scene.settings.reorderInterval);
+		} else if (key == "broadphase") {
+			ok = ReadBroadphase(stream, scene.settings.broadphase);
+		} else if (key == "verletSkin") {
+			ok = static_cast<bool>(stream >> scene.settings.verletSkin) && scene.settings.verletSkin >= 0.0f;
+		} else if (key == "parentCollision") {
+			ok = static_cast<bool>(stream >> scene.settings.parentCollision);
+		} else if (key == "contactEventThreshold") {
+			ok = static_cast<bool>(stream >> scene.settings.contactEventThreshold);
+		} else if (key == "gravity") {
+			ok = ReadVec3(stream, scene.gravity);
+		} else if (key == "linearDrag") {
+			ok = static_cast<bool>(stream >> scene.linearDrag);
+		} else {
+			// ここから先は剛体ごとのキー
+			if (scene.bodies.empty()) {
+				return Fail("'" + key + "' before any body");
+			}
+
+			BodyDescription& body = scene.bodies.back();
+			if (key == "position") {
+				ok = ReadVec3(stream, body.position);
+			} else if (key == "velocity") {
+				ok = ReadVec3(stream, body.velocity);
+			} else if (key == "radius") {
+				ok = static_cast<bool>(stream >> body.radius) && body.radius > 0.0f;
+			} else if (key == "mass") {
+				ok = static_cast<bool>(stream >> body.mass) && body.mass > 0.0f;
+			} else if (key == "restitution") {
+				ok = static_cast<bool>(stream >> body.restitution);
+			} else if (key == "static") {
+				ok = static_cast<bool>(stream >> body.isStatic);
+			} else if (key == "trigger") {
+				ok = static_cast<bool>(stream >> body.isTrigger);
+			} else if (key == "layer") {
+				ok = static_cast<bool>(stream >> body.collisionLayer);
+			} else if (key == "mask") {
+				ok = static_cast<bool>(stream >> body.collisionMask);
+			} else if (key == "maxDistance") {
+				ok = static_cast<bool>(stream >> body.maxDistanceToParent);
+			} else if (key == "parent") {
+				std::string parentName;
+				ok = static_cast<bool>(stream >> parentName);
+				// 親は自分より前に書かれている必要がある
+				const uint32_t self = static_cast<uint32_t>(scene.bodies.size() - 1);
+				body.parent = FindBody(scene.bodies, parentName);
+				if (ok && (body.parent == kNoParent || body.parent == self)) {
+					return Fail("unknown parent '" + parentName + "'");
+				}
+			} else {
+				return Fail("unknown key '" + key + "'");
+			}
+		}
+
+		if (!ok) {
+			return Fail("invalid value for '" + key + "'");
+		}
+	}
+
+	outScene = std::move(scene);
+	return true;
+}
+
+bool SceneDescription::SaveToFile(const std::string& path) const {
+	std::ofstream file(path);
+	if (!file) {
+		return false;
+	}
+	// floatを往復させても値が変わらない桁数
+	file.precision(9);
+
+	file << "deltaTime " << settings.deltaTime << "\n";
+	file << "penetrationSlop " << settings.penetrationSlop << "\n";
+	file << "baumgarteFactor " << settings.baumgarteFactor << "\n";
+	file << "reductionFactor " << settings.reductionFactor << "\n";
+	file << "maxIterations " << settings.maxIterations << "\n";
+	file << "tolerance " << settings.tolerance << "\n";
+	file << "reorderInterval " << settings.reorderInterval << "\n";
+	file << "broadphase " << kBroadphaseNames[static_cast<uint32_t>(settings.broadphase)] << "\n";
+	file << "verletSkin " << settings.verletSkin << "\n";
+	file << "parentCollision " << settings.parentCollision << "\n";
+	file << "contactEventThreshold " << settings.contactEventThreshold << "\n";
+	file << "gravity " << gravity.x << " " << gravity.y << " " << gravity.z << "\n";
+	file << "linearDrag " << linearDrag << "\n";
+
+	for (const BodyDescription& body : bodies) {
+		file << "\nbody " << body.name << "\n";
+		file << "position " << body.position.x << " " << body.position.y << " " << body.position.z << "\n";
+		file << "velocity " << body.velocity.x << " " << body.velocity.y << " " << body.velocity.z << "\n";
+		file << "radius " << body.radius << "\n";
+		file << "mass " << body.mass << "\n";
+		file << "restitution " << body.restitution << "\n";
+		file << "static " << body.isStatic << "\n";
+		if (body.isTrigger) {
+			file << "trigger " << body.isTrigger << "\n";
+		}
+		if (body.collisionLayer != kDefaultLayer || body.collisionMask != kAllLayers) {
+			file << "layer " << body.collisionLayer << "\n";
+			file << "mask " << body.collisionMask << "\n";
+		}
+		if (body.parent != kNoParent) {
+			file << "parent " << bodies[body.parent].name << "\n";
+			file << "maxDistance " << body.maxDistanceToParent << "\n";
+		}
+	}
+
+	return static_cast<bool>(file);
+}
@@ -0,0 +1,67 @@
+#pragma once
+#include <string>
+#include <vector>
+
+#include "BodyArrays.h"
+#include "Solver.h"
+
+/// <summary>
+/// シーン内の剛体1つ分の記述
+/// </summary>
+struct BodyDescription {
+	std::string name = "Sphere";
+	Vec3 position;
+	Vec3 velocity;
+	float radius = 1.0f;
+	float mass = 1.0f;
+	float restitution = 0.25f;
+	bool isStatic = false;
+	bool isTrigger = false; // 重なりを知らせるだけで、ぶつからない
+	uint32_t collisionLayer = kDefaultLayer; // 自分が属するレイヤーのビット
+	uint32_t collisionMask = kAllLayers; // 衝突する相手のレイヤーのビット
+	uint32_t parent = kNoParent; // 距離拘束でつながる親の添字 (自分より前にあること)
+	float maxDistanceToParent = -1.0f; // 負なら初期配置での親との距離
+};
+
+/// <summary>
+/// 物理ワールドを構築するためのシーンの記述
+/// </summary>
+struct SceneDescription {
+	std::vector<BodyDescription> bodies;
+	SolverSettings settings;
+	Vec3 gravity;
+	float linearDrag = 0.0f;
+
+	/// <summary>
+	/// 根元の球にlinks個の球を数珠つなぎにし、離れた所にもう1つ球を置いたシーン
+	/// </summary>
+	static SceneDescription MakeChain(uint32_t links);
+
+	/// <summary>
+	/// 立方体の中にcount個の球をランダムな位置と速度でまばらに置いた無重力のシーン
+	/// </summary>
+	static SceneDescription MakeGas(uint32_t count, uint32_t seed = 1);
+
+	/// <summary>
+	/// 静的な床の層の上にcount個の球を少し重ねて積んだシーン
+	/// </summary>
+	static SceneDescription MakePile(uint32_t count, uint32_t seed = 1);
+
+	/// <summary>
+	/// count個の球を接する間隔で立方格子状に並べた静止したシーン
+	/// </summary>
+	static SceneDescription MakeLattice(uint32_t count);
+
+	/// <summary>
+	/// テキスト形式のシーンファイルを読み込みます
+	/// 1行に「キー 値...」を書き、body行以降の剛体のキーはその剛体に適用されます
+	/// </summary>
+	/// <param name="outError">失敗したときの理由 (行番号つき)</param>
+	/// <returns>読み込めたらtrue</returns>
+	static bool LoadFromFile(const std::string& path, SceneDescription& outScene, std::string& outError);
+
+	/// <summary>
+	/// LoadFromFileで読める形式で書き出します
+	/// </summary>
+	bool SaveToFile(const std::string& path) const;
+};
@@ -0,0 +1,110 @@
+#include "Solver.h"
+
+#include <algorithm>
+
+bool ComputeSphereContact(const Vec3& positionA, const float radiusA, const Vec3& positionB, const float radiusB,
+	ContactManifold& outContact) {
+	const Vec3 delta = positionB - positionA;
+	const float radiusSum = radiusA + radiusB;
+	const float sqrDistance = delta.SqrtLength();
+	if (sqrDistance >= radiusSum * radiusSum) {
+		return false;
+	}
+
+	const float distance = delta.Length();
+	// 中心が一致している場合は適当な方向に押し出す
+	outContact.normal = distance > 0.0f ? delta / distance : Vec3(0.0f, 1.0f, 0.0f);
+	outContact.penetration = radiusSum - distance;
+	return true;
+}
+
+float SolveContactVelocity(const ContactManifold& contact, Vec3& velocityA, const float inverseMassA,
+	Vec3& velocityB, const float inverseMassB, const float restitution) {
+	const float inverseMassSum = inverseMassA + inverseMassB;
+	if (inverseMassSum <= 0.0f) {
+		return 0.0f;
+	}
+
+	const float relativeVelocity = (velocityB - velocityA).DotProduct(contact.normal);
+	// 離れようとしている
+	if (relativeVelocity > 0.0f) {
+		return 0.0f;
+	}
+
+	const float j = -(1.0f + restitution) * relativeVelocity / inverseMassSum;
+
+	const Vec3 impulse = contact.normal * j;
+	velocityA -= impulse * inverseMassA;
+	velocityB += impulse * inverseMassB;
+	return j;
+}
+
+void SolveContactPosition(const ContactManifold& contact, Vec3& pseudoVelocityA, const float inverseMassA,
+	Vec3& pseudoVelocityB, const float inverseMassB, const SolverSettings& settings) {
+	const float inverseMassSum = inverseMassA + inverseMassB;
+	if (inverseMassSum <= 0.0f) {
+		return;
+	}
+
+	// 許容量を超えたぶんだけをバウムガルテ係数で少しずつ戻す
+	const float error = std::max(contact.penetration - settings.penetrationSlop, 0.0f);
+	const float bias = settings.baumgarteFactor * error / settings.deltaTime;
+
+	const float relativeVelocity = (pseudoVelocityB - pseudoVelocityA).DotProduct(contact.normal);
+	const float velocityError = std::max(bias - relativeVelocity, 0.0f);
+	const float lambda = velocityError / inverseMassSum;
+
+	const Vec3 impulse = contact.normal * lambda;
+	pseudoVelocityA -= impulse * inverseMassA;
+	pseudoVelocityB += impulse * inverseMassB;
+}
+
+float ComputeContactPositionError(const ContactManifold& contact, const Vec3& pseudoVelocityA,
+	const Vec3& pseudoVelocityB, const SolverSettings& settings) {
+	// 疑似速度で離れる距離だけめり込みが減る
+	const float separation = (pseudoVelocityB - pseudoVelocityA).DotProduct(contact.normal) * settings.deltaTime;
+	return std::max(contact.penetration - settings.penetrationSlop - separation, 0.0f);
+}
+
+float SolveDistanceConstraint(Vec3& positionA, const float inverseMassA, Vec3& positionB, const float inverseMassB,
+	const float maxDistance) {
+	const float inverseMassSum = inverseMassA + inverseMassB;
+	if (inverseMassSum <= 0.0f) {
+		return 0.0f;
+	}
+
+	const Vec3 direction = positionB - positionA;
+	const float currentDistance = direction.Length();
+
+	// 最大距離以内なら何もしない
+	if (currentDistance <= maxDistance) {
+		return 0.0f;
+	}
+
+	// 質量の逆数の比で両方を範囲内に戻す
+	const float error = currentDistance - maxDistance;
+	const Vec3 correction = direction * (error / (currentDistance * inverseMassSum));
+	positionA += correction * inverseMassA;
+	positionB -= correction * inverseMassB;
+
+	return error;
+}
+
+void DampDistanceConstraint(const Vec3& positionA, Vec3& velocityA, const float inverseMassA,
+	const Vec3& positionB, Vec3& velocityB, const float inverseMassB, const float reductionFactor) {
+	const Vec3 direction = positionB - positionA;
+	// Avoid division by zero
+	if (direction.SqrtLength() <= 0.0f) {
+		return;
+	}
+
+	const Vec3 normal = direction.Normalized();
+	const Vec3 relativeVelocity = velocityB - velocityA;
+	const Vec3 velocityAlongNormal = normal * relativeVelocity.DotProduct(normal);
+	if (inverseMassA > 0.0f) {
+		velocityA += velocityAlongNormal * reductionFactor;
+	}
+	if (inverseMassB > 0.0f) {
+		velocityB -= velocityAlongNormal * reductionFactor;
+	}
+}
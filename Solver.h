@@ -0,0 +1,92 @@
+#pragma once
+#include <cstdint>
+
+#include "Config.h"
+#include "Vec3.h"
+
+/// <summary>
+/// ブロードフェーズの方式
+/// </summary>
+enum class BroadphaseType : uint32_t {
+	Grid, // ハッシュ化した一様グリッド (大きさがそろった球向け)
+	Lbvh, // 毎ステップ作り直す線形BVH (大きさがばらばら・全体が動き回るシーン向け)
+	Verlet, // スキン付きの近傍リストを数ステップ使い回す (動きの遅い密なシーン向け)
+};
+
+// シーンファイルやコマンドラインで使う名前 (BroadphaseTypeの順)
+inline constexpr const char* kBroadphaseNames[] = {"grid", "lbvh", "verlet"};
+
+/// <summary>
+/// ソルバーのパラメータ
+/// ワールドごとに持つので、別々の設定で並列に回せます
+/// </summary>
+struct SolverSettings {
+	float deltaTime = ::deltaTime;
+	float penetrationSlop = 0.01f; // 接触のめり込み許容量
+	float baumgarteFactor = 0.2f; // めり込みを1ステップで戻す割合
+	float reductionFactor = 0.175f; // 距離拘束方向の相対速度の減衰率
+	uint32_t maxIterations = 8; // 最大反復回数
+	float tolerance = 0.001f; // 反復後に残った誤差 (めり込み・距離の超過、長さ) の最大がこれを下回ったら反復を打ち切る
+	uint32_t reorderInterval = 0; // 剛体をモートン順に並べ替える間隔 (ステップ数、0なら並べ替えない)
+	BroadphaseType broadphase = BroadphaseType::Grid;
+	float verletSkin = 0.2f; // 近傍リストの余裕 (broadphaseがVerletのとき)
+	bool parentCollision = true; // 距離拘束でつながった親子どうしも衝突させるか
+	float contactEventThreshold = -1.0f; // 接触イベントを出す撃力の下限 (負なら出さない)
+};
+
+/// <summary>
+/// 1ステップ分のソルバーの収束状況
+/// </summary>
+struct SolverStats {
+	uint32_t iterations = 0; // 実行した反復回数
+	float residual = 0.0f; // 最後の反復の後に残った誤差の最大 (めり込み・距離の超過、長さ)
+};
+
+/// <summary>
+/// 二球間の接触情報
+/// </summary>
+struct ContactManifold {
+	Vec3 normal; // aからbへ向かう法線
+	float penetration; // めり込み深度
+};
+
+/// <summary>
+/// 二球の接触情報を計算します
+/// </summary>
+/// <returns>重なっていればtrue</returns>
+bool ComputeSphereContact(const Vec3& positionA, float radiusA, const Vec3& positionB, float radiusB,
+	ContactManifold& outContact);
+
+/// <summary>
+/// 接触の速度拘束を解き、法線方向の撃力を加えます
+/// </summary>
+/// <returns>加えた撃力の大きさ</returns>
+float SolveContactVelocity(const ContactManifold& contact, Vec3& velocityA, float inverseMassA,
+	Vec3& velocityB, float inverseMassB, float restitution);
+
+/// <summary>
+/// スプリットインパルスでめり込みを解消します
+/// 実際の速度には触れず、位置補正用の疑似速度だけを変更します
+/// </summary>
+void SolveContactPosition(const ContactManifold& contact, Vec3& pseudoVelocityA, float inverseMassA,
+	Vec3& pseudoVelocityB, float inverseMassB, const SolverSettings& settings);
+
+/// <summary>
+/// 今の疑似速度で位置を1ステップ進めたあとに残るめり込み (許容量を除いた長さ)
+/// 疑似速度は反復の間は位置を動かさないので、反復後の誤差はこれで見積もります
+/// </summary>
+float ComputeContactPositionError(const ContactManifold& contact, const Vec3& pseudoVelocityA,
+	const Vec3& pseudoVelocityB, const SolverSettings& settings);
+
+/// <summary>
+/// 二点間の距離がmaxDistanceを超えないように位置を直接補正します
+/// </summary>
+/// <returns>解く前の超過量 (長さ)</returns>
+float SolveDistanceConstraint(Vec3& positionA, float inverseMassA, Vec3& positionB, float inverseMassB,
+	float maxDistance);
+
+/// <summary>
+/// 二点を結ぶ方向の相対速度を減衰させます
+/// </summary>
+void DampDistanceConstraint(const Vec3& positionA, Vec3& velocityA, float inverseMassA,
+	const Vec3& positionB, Vec3& velocityB, float inverseMassB, float reductionFactor);
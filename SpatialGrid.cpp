@@ -0,0 +1,289 @@
+#include "SpatialGrid.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "CollisionFilter.h"
+
+namespace {
+	constexpr float kMinCellSize = 0.001f;
+	constexpr uint32_t kMinTableSize = 64;
+}
+
+void SpatialGrid::Build(const std::span<const Vec3> positions, const std::span<const float> radii, const float cellSize) {
+	positions_.assign(positions.begin(), positions.end());
+	radii_.assign(radii.begin(), radii.end());
+
+	const uint32_t count = GetBodyCount();
+
+	float maxRadius = 0.0f;
+	for (const float radius : radii_) {
+		maxRadius = std::max(maxRadius, radius);
+	}
+
+	// 最大半径の2倍あれば隣接セルだけで重なりを判定できる
+	// FindPairsは隣接セルしか見ないので、指定がそれより小さくても2倍までは広げる
+	cellSize_ = std::max({cellSize, maxRadius * 2.0f, kMinCellSize});
+	invCellSize_ = 1.0f / cellSize_;
+
+	// 剛体数の2倍以上の2のべき乗をテーブルサイズにする
+	uint32_t tableSize = kMinTableSize;
+	while (tableSize < count * 2) {
+		tableSize <<= 1;
+	}
+	tableMask_ = tableSize - 1;
+
+	cellStart_.assign(tableSize + 1, 0);
+	entries_.resize(count);
+
+	// バケットごとの個数を数える
+	for (uint32_t i = 0; i < count; ++i) {
+		const Cell cell = CellOf(positions_[i]);
+		++cellStart_[Hash(cell) + 1];
+
+		if (i == 0) {
+			minCell_ = cell;
+			maxCell_ = cell;
+		} else {
+			minCell_ = {std::min(minCell_.x, cell.x), std::min(minCell_.y, cell.y), std::min(minCell_.z, cell.z)};
+			maxCell_ = {std::max(maxCell_.x, cell.x), std::max(maxCell_.y, cell.y), std::max(maxCell_.z, cell.z)};
+		}
+	}
+
+	for (uint32_t i = 0; i < tableSize; ++i) {
+		cellStart_[i + 1] += cellStart_[i];
+	}
+
+	// バケット順に並べ替える (カウンティングソート)
+	cellCursor_.assign(cellStart_.begin(), cellStart_.end() - 1);
+	for (uint32_t i = 0; i < count; ++i) {
+		const Cell cell = CellOf(positions_[i]);
+		entries_[cellCursor_[Hash(cell)]++] = {cell, i};
+	}
+}
+
+void SpatialGrid::FindPairs(std::vector<BodyPair>& outPairs, const CollisionFilter* filter) const {
+	outPairs.clear();
+
+	for (const Entry& entry : entries_) {
+		const uint32_t i = entry.index;
+		const Vec3& position = positions_[i];
+
+		for (int32_t dz = -1; dz <= 1; ++dz) {
+			for (int32_t dy = -1; dy <= 1; ++dy) {
+				for (int32_t dx = -1; dx <= 1; ++dx) {
+					const Cell cell = {entry.cell.x + dx, entry.cell.y + dy, entry.cell.z + dz};
+					const uint32_t bucket = Hash(cell);
+
+					for (uint32_t e = cellStart_[bucket]; e < cellStart_[bucket + 1]; ++e) {
+						const Entry& other = entries_[e];
+						// 重複を避けるため j > i のみ
+						if (other.index <= i || !(other.cell == cell)) {
+							continue;
+						}
+						if (filter != nullptr && !filter->ShouldCollide(i, other.index)) {
+							continue;
+						}
+
+						const float radiusSum = radii_[i] + radii_[other.index];
+						if ((positions_[other.index] - position).SqrtLength() < radiusSum * radiusSum) {
+							outPairs.push_back({i, other.index});
+						}
+					}
+				}
+			}
+		}
+	}
+}
+
+void SpatialGrid::QueryRadius(const Vec3& point, const float radius, std::vector<uint32_t>& outIndices) const {
+	outIndices.clear();
+	ForEachInRadius(point, radius, [&](const uint32_t index, float) {
+		outIndices.push_back(index);
+	});
+}
+
+void SpatialGrid::QueryKNearest(const Vec3& point, const uint32_t k, std::vector<uint32_t>& outIndices) {
+	outIndices.clear();
+	CollectKNearest(point, k, UINT32_MAX);
+	for (const Neighbor& neighbor : heap_) {
+		outIndices.push_back(neighbor.index);
+	}
+}
+
+void SpatialGrid::BuildNeighborList(const float radius, std::vector<uint32_t>& outOffsets,
+	std::vector<uint32_t>& outNeighbors) const {
+	const uint32_t count = GetBodyCount();
+	outOffsets.resize(count + 1);
+	outNeighbors.clear();
+
+	for (uint32_t i = 0; i < count; ++i) {
+		outOffsets[i] = static_cast<uint32_t>(outNeighbors.size());
+		ForEachInRadius(positions_[i], radius, [&](const uint32_t index, float) {
+			if (index != i) {
+				outNeighbors.push_back(index);
+			}
+		});
+	}
+	outOffsets[count] = static_cast<uint32_t>(outNeighbors.size());
+}
+
+void SpatialGrid::BuildKNearestList(const uint32_t k, std::vector<uint32_t>& outOffsets,
+	std::vector<uint32_t>& outNeighbors) {
+	const uint32_t count = GetBodyCount();
+	outOffsets.resize(count + 1);
+	outNeighbors.clear();
+
+	for (uint32_t i = 0; i < count; ++i) {
+		outOffsets[i] = static_cast<uint32_t>(outNeighbors.size());
+		CollectKNearest(positions_[i], k, i);
+		for (const Neighbor& neighbor : heap_) {
+			outNeighbors.push_back(neighbor.index);
+		}
+	}
+	outOffsets[count] = static_cast<uint32_t>(outNeighbors.size());
+}
+
+SpatialGrid::Cell SpatialGrid::CellOf(const Vec3& position) const {
+	return {
+		static_cast<int32_t>(std::floor(position.x * invCellSize_)),
+		static_cast<int32_t>(std::floor(position.y * invCellSize_)),
+		static_cast<int32_t>(std::floor(position.z * invCellSize_))
+	};
+}
+
+uint32_t SpatialGrid::Hash(const Cell& cell) const {
+	const uint32_t h =
+		static_cast<uint32_t>(cell.x) * 73856093u ^
+		static_cast<uint32_t>(cell.y) * 19349663u ^
+		static_cast<uint32_t>(cell.z) * 83492791u;
+	return h & tableMask_;
+}
+
+template <typename Func>
+void SpatialGrid::ForEachInRadius(const Vec3& point, const float radius, Func&& func) const {
+	const float sqrRadius = radius * radius;
+	// 半径が大きいと整数に収まらないので、総当たりにするかはfloatのまま判定してから整数にする
+	const float rangeCells = std::ceil(radius * invCellSize_);
+
+	// 走査するセル数が剛体数より多いなら総当たりの方が速い
+	const float cellsToVisit = std::pow(rangeCells * 2.0f + 1.0f, 3.0f);
+	if (!(cellsToVisit <= static_cast<float>(entries_.size()))) {
+		for (uint32_t i = 0; i < GetBodyCount(); ++i) {
+			const float sqrDistance = (positions_[i] - point).SqrtLength();
+			if (sqrDistance <= sqrRadius) {
+				func(i, sqrDistance);
+			}
+		}
+		return;
+	}
+
+	const int32_t range = static_cast<int32_t>(rangeCells);
+	const Cell center = CellOf(point);
+	for (int32_t dz = -range; dz <= range; ++dz) {
+		for (int32_t dy = -range; dy <= range; ++dy) {
+			for (int32_t dx = -range; dx <= range; ++dx) {
+				const Cell cell = {center.x + dx, center.y + dy, center.z + dz};
+				const uint32_t bucket = Hash(cell);
+
+				for (uint32_t e = cellStart_[bucket]; e < cellStart_[bucket + 1]; ++e) {
+					const Entry& entry = entries_[e];
+					if (!(entry.cell == cell)) {
+						continue;
+					}
+
+					const float sqrDistance = (positions_[entry.index] - point).SqrtLength();
+					if (sqrDistance <= sqrRadius) {
+						func(entry.index, sqrDistance);
+					}
+				}
+			}
+		}
+	}
+}
+
+void SpatialGrid::CollectKNearest(const Vec3& point, const uint32_t k, const uint32_t exclude) {
+	heap_.clear();
+
+	const uint32_t available = exclude < GetBodyCount() ? GetBodyCount() - 1 : GetBodyCount();
+	const uint32_t wanted = std::min(k, available);
+	if (wanted == 0) {
+		return;
+	}
+
+	// 最大ヒープで上位k個を保持する
+	const auto Offer = [&](const uint32_t index) {
+		const float sqrDistance = (positions_[index] - point).SqrtLength();
+		if (heap_.size() < wanted) {
+			heap_.push_back({sqrDistance, index});
+			std::push_heap(heap_.begin(), heap_.end());
+		} else if (sqrDistance < heap_.front().sqrDistance) {
+			std::pop_heap(heap_.begin(), heap_.end());
+			heap_.back() = {sqrDistance, index};
+			std::push_heap(heap_.begin(), heap_.end());
+		}
+	};
+
+	const Cell center = CellOf(point);
+	const auto VisitCell = [&](const int32_t dx, const int32_t dy, const int32_t dz) {
+		const Cell cell = {center.x + dx, center.y + dy, center.z + dz};
+		const uint32_t bucket = Hash(cell);
+		for (uint32_t e = cellStart_[bucket]; e < cellStart_[bucket + 1]; ++e) {
+			const Entry& entry = entries_[e];
+			if (entry.cell == cell && entry.index != exclude) {
+				Offer(entry.index);
+			}
+		}
+	};
+
+	// 中心セルからグリッド端までのリング数
+	const int32_t maxRing = std::max({
+		std::abs(center.x - minCell_.x), std::abs(center.x - maxCell_.x),
+		std::abs(center.y - minCell_.y), std::abs(center.y - maxCell_.y),
+		std::abs(center.z - minCell_.z), std::abs(center.z - maxCell_.z)
+	});
+
+	for (int32_t ring = 0; ring <= maxRing; ++ring) {
+		// 見終わったセル数が剛体数に届いたら、残りは総当たりの方が速い (離れた剛体が1つあるだけでもリングは増える)
+		const double visitedCells = std::pow(static_cast<double>(ring * 2 - 1), 3.0);
+		if (ring > 0 && visitedCells >= static_cast<double>(entries_.size())) {
+			heap_.clear();
+			for (uint32_t i = 0; i < GetBodyCount(); ++i) {
+				if (i != exclude) {
+					Offer(i);
+				}
+			}
+			break;
+		}
+
+		if (ring == 0) {
+			VisitCell(0, 0, 0);
+		} else {
+			// リングの外殻の6面だけを見る (辺と角は先に見た面に含まれる)
+			for (int32_t dy = -ring; dy <= ring; ++dy) {
+				for (int32_t dx = -ring; dx <= ring; ++dx) {
+					VisitCell(dx, dy, -ring);
+					VisitCell(dx, dy, ring);
+				}
+			}
+			for (int32_t dz = -ring + 1; dz < ring; ++dz) {
+				for (int32_t dx = -ring; dx <= ring; ++dx) {
+					VisitCell(dx, -ring, dz);
+					VisitCell(dx, ring, dz);
+				}
+				for (int32_t dy = -ring + 1; dy < ring; ++dy) {
+					VisitCell(-ring, dy, dz);
+					VisitCell(ring, dy, dz);
+				}
+			}
+		}
+
+		// 次のリングはすべて ring * cellSize より遠い
+		const float bound = static_cast<float>(ring) * cellSize_;
+		if (heap_.size() == wanted && heap_.front().sqrDistance <= bound * bound) {
+			break;
+		}
+	}
+
+	std::sort_heap(heap_.begin(), heap_.end());
+}
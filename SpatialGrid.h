@@ -0,0 +1,116 @@
+#pragma once
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include "Vec3.h"
+
+struct CollisionFilter;
+
+/// <summary>
+/// ブロードフェーズが出力する剛体のペア (a < b)
+/// </summary>
+struct BodyPair {
+	uint32_t a;
+	uint32_t b;
+};
+
+/// <summary>
+/// ハッシュ化した一様グリッドによる空間分割
+/// 近傍探索 (半径 / k近傍) と衝突ペアの列挙を行います
+/// </summary>
+class SpatialGrid {
+public:
+	/// <summary>
+	/// グリッドを構築します
+	/// </summary>
+	/// <param name="positions">剛体の中心座標</param>
+	/// <param name="radii">剛体の半径</param>
+	/// <param name="cellSize">セルの大きさ。最大半径の2倍より小さければ (0以下も) 最大半径の2倍を使用</param>
+	void Build(std::span<const Vec3> positions, std::span<const float> radii, float cellSize = 0.0f);
+
+	/// <summary>
+	/// 球同士が重なっている可能性のあるペアを列挙します
+	/// </summary>
+	/// <param name="filter">渡すと衝突させない組を距離を測る前に除きます</param>
+	void FindPairs(std::vector<BodyPair>& outPairs, const CollisionFilter* filter = nullptr) const;
+
+	/// <summary>
+	/// pointから半径radius以内に中心がある剛体を列挙します
+	/// </summary>
+	void QueryRadius(const Vec3& point, float radius, std::vector<uint32_t>& outIndices) const;
+
+	/// <summary>
+	/// pointに近い順にk個の剛体を列挙します
+	/// </summary>
+	void QueryKNearest(const Vec3& point, uint32_t k, std::vector<uint32_t>& outIndices);
+
+	/// <summary>
+	/// すべての剛体について半径radius以内の近傍をCSR形式で書き出します
+	/// i番目の近傍は outNeighbors[outOffsets[i]] ～ outNeighbors[outOffsets[i + 1] - 1]
+	/// </summary>
+	void BuildNeighborList(float radius, std::vector<uint32_t>& outOffsets, std::vector<uint32_t>& outNeighbors) const;
+
+	/// <summary>
+	/// すべての剛体について近い順にk個の近傍をCSR形式で書き出します
+	/// </summary>
+	void BuildKNearestList(uint32_t k, std::vector<uint32_t>& outOffsets, std::vector<uint32_t>& outNeighbors);
+
+	uint32_t GetBodyCount() const {
+		return static_cast<uint32_t>(positions_.size());
+	}
+
+	float GetCellSize() const {
+		return cellSize_;
+	}
+
+private:
+	struct Cell {
+		int32_t x, y, z;
+
+		bool operator==(const Cell& rhs) const {
+			return x == rhs.x && y == rhs.y && z == rhs.z;
+		}
+	};
+
+	struct Entry {
+		Cell cell;
+		uint32_t index;
+	};
+
+	struct Neighbor {
+		float sqrDistance;
+		uint32_t index;
+
+		bool operator<(const Neighbor& rhs) const {
+			return sqrDistance < rhs.sqrDistance;
+		}
+	};
+
+	Cell CellOf(const Vec3& position) const;
+	uint32_t Hash(const Cell& cell) const;
+
+	template <typename Func>
+	void ForEachInRadius(const Vec3& point, float radius, Func&& func) const;
+
+	void CollectKNearest(const Vec3& point, uint32_t k, uint32_t exclude);
+
+	std::vector<Vec3> positions_;
+	std::vector<float> radii_;
+
+	// ハッシュバケットごとの開始位置 (CSR)
+	std::vector<uint32_t> cellStart_;
+	std::vector<uint32_t> cellCursor_;
+	// バケット順に並べた剛体
+	std::vector<Entry> entries_;
+
+	// k近傍探索用の作業領域
+	std::vector<Neighbor> heap_;
+
+	Cell minCell_ = {0, 0, 0};
+	Cell maxCell_ = {0, 0, 0};
+
+	float cellSize_ = 1.0f;
+	float invCellSize_ = 1.0f;
+	uint32_t tableMask_ = 0;
+};
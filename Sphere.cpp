@@ -2,7 +2,9 @@
 
 #include "Sphere.h"
 
+#include "Config.h"
 #include "PrimitiveDrawer.h"
+#include "Profiler.h"
 
 Sphere::~Sphere() {
 }
@@ -30,71 +32,15 @@ void Sphere::Initialize(const std::string& name) {
 	}
 }
 
-void Sphere::ResolveCollision(Sphere& other) {
-	Vec3 normal = (other.transform_.translation_.ConvertToVec3() - this->transform_.translation_.ConvertToVec3()).Normalized();
-	float relativeVelocity = (other.rb_.GetVelocity() - this->rb_.GetVelocity()).DotProduct(normal);
-
-	// めり込み深度を計算
-	float distance = (other.transform_.translation_.ConvertToVec3() - this->transform_.translation_.ConvertToVec3()).Length();
-	float penetrationDepth = (this->circleRadius_ + other.circleRadius_) - distance;
-
-	// 侵入している場合は位置を補正
-	if (penetrationDepth > 0) {
-		Vec3 correction = normal * (penetrationDepth / (this->rb_.GetMass() + other.rb_.GetMass()));
-		for (int i = 0; i < 3; ++i) {
-			this->transform_.translation_[i] -= correction[i] * (other.rb_.GetMass() / (this->rb_.GetMass() + other.rb_.GetMass()));
-			other.transform_.translation_[i] += correction[i] * (this->rb_.GetMass() / (this->rb_.GetMass() + other.rb_.GetMass()));
-		}
-	}
-
-	if (relativeVelocity > 0) {
-		return;
-	}
-
-	float e = min(this->rb_.GetReboundCoefficient(), other.rb_.GetReboundCoefficient());
-	float j = -(1 + e) * relativeVelocity;
-	j /= 1 / this->rb_.GetMass() + 1 / other.rb_.GetMass();
-
-	Vec3 impulse = normal * j;
-	this->rb_.SetVelocity(this->rb_.GetVelocity() - impulse / this->rb_.GetMass());
-	other.rb_.SetVelocity(other.rb_.GetVelocity() + impulse / other.rb_.GetMass());
-}
-
 void Sphere::Update() {
+	PROFILE_ZONE("Sphere::Update");
 	// スタティックだったら
 	if (isStatic) {
 		// 速度はゼロ
 		rb_.SetVelocity(Vec3::zero);
-	} else {
-		// 剛体の更新
-		rb_.Update(this, collisionShapes_);
-
-		ApplyDistanceConstraint();
-
-		// 子の当たり判定
-		for (auto& child : children_) {
-			if (auto circleChild = dynamic_cast<Sphere*>(child.get())) {
-				// 衝突していたら
-				if (IsCollide(*circleChild)) {
-					// 外に出す
-					ResolveCollision(*circleChild);
-				}
-
-				// 他の子同士も判定を行う
-				for (auto& otherChild : children_) {
-					if (circleChild != otherChild.get()) {
-						if (auto otherCircleChild = dynamic_cast<Sphere*>(otherChild.get())) {
-							if (circleChild->IsCollide(*otherCircleChild)) {
-								circleChild->ResolveCollision(*otherCircleChild);
-							}
-						}
-					}
-				}
-			}
-		}
 	}
-
-	transform_.UpdateMatrix();
+	// 移動と衝突はPhysicsWorldで解く
+	// ワールド行列はGameSceneのTransformHierarchyでまとめて計算する
 
 	// 子を更新
 	for (auto& child : children_) {
@@ -103,8 +49,9 @@ void Sphere::Update() {
 }
 
 void Sphere::Draw(const ViewProjection& viewProjection) {
-
-	model_->Draw(transform_, viewProjection);
+	if (visible_) {
+		model_->Draw(transform_, viewProjection);
+	}
 	for (auto& child : children_) {
 		child->Draw(viewProjection);
 	}
@@ -173,57 +120,25 @@ void Sphere::Details() {
 	}
 }
 
-Rigidbody Sphere::GetRigidbody() const {
+const Rigidbody& Sphere::GetRigidbody() const {
 	return rb_;
 }
 
+void Sphere::SetVelocity(const Vec3& velocity) {
+	rb_.SetVelocity(velocity);
+}
+
 bool Sphere::GetStatic() const {
 	return isStatic;
 }
 
-void Sphere::ApplyDistanceConstraint() {
-	// 親がある場合
-	if (parent_) {
-		// 子がCircleだった場合
-		if (auto p = dynamic_cast<Sphere*>(parent_.get())) {
-			Vec3 direction;
-
-			for (int i = 0; i < 3; ++i) {
-				direction[i] = transform_.translation_[i] - parent_->GetTransform().position[i];
-			}
-			float currentDistance = direction.Length();
-
-			// 最大距離より遠くにいたら
-			if (currentDistance > maxDistanceToParent_) {
-				Vec3 normal = direction.Normalized();
-				Vec3 correction = normal * (currentDistance - maxDistanceToParent_);
-				for (int i = 0; i < 3; ++i) {
-					transform_.translation_[i] -= correction[i] * 0.5f;
-				}
-
-				// 範囲内に戻す
-				if (!p->GetStatic()) {
-					parent_->SetTransform(
-						{parent_->GetTransform().position + correction * 0.5f},
-						parent_->GetTransform().rotation,
-						parent_->GetTransform().scale
-					);
-				}
-			}
-
-			if (currentDistance > 0.0f) {
-				// Avoid division by zero
-				Vec3 relativeVelocity = rb_.GetVelocity() - p->GetRigidbody().GetVelocity();
-				Vec3 velocityAlongNormal = direction.Normalized() * relativeVelocity.DotProduct(
-					direction.Normalized());
-				rb_.SetVelocity(rb_.GetVelocity() - velocityAlongNormal * reductionFactor);
-				p->GetRigidbody().SetVelocity(
-					p->GetRigidbody().GetVelocity() + velocityAlongNormal * reductionFactor);
-			}
-		}
-	}
+float Sphere::GetInverseMass() const {
+	return isStatic ? 0.0f : 1.0f / rb_.GetMass();
 }
 
+float Sphere::GetMaxDistanceToParent() const {
+	return maxDistanceToParent_;
+}
 
 void Sphere::SetModel(Model* model) {
 	model_ = model;
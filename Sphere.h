@@ -22,20 +22,27 @@ public:
 
 	void SetModel(Model* model);
 
-	void ResolveCollision(Sphere& other);
-
 	void Update() override;
 
 	void Draw(const ViewProjection& viewProjection) override;
 	void DebugDraw() const;
 
+	// falseならDrawでこの球のモデルだけを描かない (子は子の設定に従う)
+	void SetVisible(bool visible) {
+		visible_ = visible;
+	}
+
 	void Details() override;
 
-	Rigidbody GetRigidbody() const;
+	const Rigidbody& GetRigidbody() const;
+	void SetVelocity(const Vec3& velocity);
 
 	bool GetStatic() const;
 
-	void ApplyDistanceConstraint();
+	// スタティックなら0
+	float GetInverseMass() const;
+
+	float GetMaxDistanceToParent() const;
 
 private:
 	float circleRadius_ = 1.0f;
@@ -47,5 +54,7 @@ private:
 
 	bool isStatic = false;
 
+	bool visible_ = true;
+
 	Model* model_;
 };
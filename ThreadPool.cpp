@@ -0,0 +1,130 @@
+#include "ThreadPool.h"
+
+#include <algorithm>
+
+#include "Profiler.h"
+
+namespace {
+	// ワーカースレッド上、またはParallelForの呼び出し元がジョブを実行中かどうか
+	thread_local bool isWorkerThread = false;
+
+	/// <summary>
+	/// スコープの間だけisWorkerThreadを立て、抜けるときに元に戻します
+	/// </summary>
+	class WorkerThreadScope {
+	public:
+		WorkerThreadScope() : previous_(isWorkerThread) {
+			isWorkerThread = true;
+		}
+		~WorkerThreadScope() {
+			isWorkerThread = previous_;
+		}
+
+		WorkerThreadScope(const WorkerThreadScope&) = delete;
+		WorkerThreadScope& operator=(const WorkerThreadScope&) = delete;
+
+	private:
+		bool previous_;
+	};
+}
+
+ThreadPool::ThreadPool(const uint32_t workerCount) {
+	uint32_t count = workerCount;
+	if (count == kDefaultWorkerCount) {
+		const uint32_t hardware = std::thread::hardware_concurrency();
+		count = hardware > 1 ? hardware - 1 : 0;
+	}
+
+	workers_.reserve(count);
+	for (uint32_t i = 0; i < count; ++i) {
+		workers_.emplace_back([this] { WorkerLoop(); });
+	}
+}
+
+ThreadPool::~ThreadPool() {
+	{
+		std::lock_guard lock(mutex_);
+		stop_ = true;
+	}
+	wake_.notify_all();
+	for (std::thread& worker : workers_) {
+		worker.join();
+	}
+}
+
+ThreadPool* ThreadPool::GetInstance() {
+	static ThreadPool instance;
+	return &instance;
+}
+
+void ThreadPool::ParallelFor(const uint32_t count, const uint32_t grainSize, const RangeFunc& func) {
+	if (count == 0) {
+		return;
+	}
+
+	const uint32_t grain = std::max(grainSize, 1u);
+
+	// 分割するほどの量がないか、入れ子の呼び出しならその場で実行する
+	if (workers_.empty() || isWorkerThread || count <= grain) {
+		func(0, count);
+		return;
+	}
+
+	std::lock_guard submitLock(submitMutex_);
+	{
+		std::lock_guard lock(mutex_);
+		job_ = &func;
+		count_ = count;
+		grainSize_ = grain;
+		next_.store(0, std::memory_order_relaxed);
+		busyWorkers_ = static_cast<uint32_t>(workers_.size());
+		++generation_;
+	}
+	wake_.notify_all();
+
+	// 呼び出し元が受け持った範囲からParallelForが呼ばれても、submitMutex_を取り直さず逐次実行させる
+	{
+		WorkerThreadScope scope;
+		RunChunks();
+	}
+
+	// すべてのワーカーが手を離すまで待つ
+	std::unique_lock lock(mutex_);
+	done_.wait(lock, [this] { return busyWorkers_ == 0; });
+	job_ = nullptr;
+}
+
+void ThreadPool::WorkerLoop() {
+	isWorkerThread = true;
+	uint64_t seenGeneration = 0;
+
+	while (true) {
+		{
+			std::unique_lock lock(mutex_);
+			wake_.wait(lock, [&] { return stop_ || generation_ != seenGeneration; });
+			if (stop_) {
+				return;
+			}
+			seenGeneration = generation_;
+		}
+
+		RunChunks();
+
+		{
+			std::lock_guard lock(mutex_);
+			--busyWorkers_;
+		}
+		done_.notify_one();
+	}
+}
+
+void ThreadPool::RunChunks() {
+	PROFILE_ZONE("ThreadPool::RunChunks");
+	while (true) {
+		const uint32_t begin = next_.fetch_add(grainSize_, std::memory_order_relaxed);
+		if (begin >= count_) {
+			return;
+		}
+		(*job_)(begin, std::min(begin + grainSize_, count_));
+	}
+}
@@ -0,0 +1,71 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/// <summary>
+/// 固定数のワーカーで範囲を分割して並列実行するスレッドプール
+/// </summary>
+class ThreadPool {
+public:
+	/// <summary>
+	/// 範囲 [begin, end) を処理する関数
+	/// </summary>
+	using RangeFunc = std::function<void(uint32_t begin, uint32_t end)>;
+
+	// ワーカースレッド数にハードウェアスレッド数 - 1 を使う
+	static constexpr uint32_t kDefaultWorkerCount = UINT32_MAX;
+
+	/// <param name="workerCount">ワーカースレッド数。0なら呼び出し元だけで実行する</param>
+	explicit ThreadPool(uint32_t workerCount = kDefaultWorkerCount);
+	~ThreadPool();
+
+	ThreadPool(const ThreadPool&) = delete;
+	ThreadPool& operator=(const ThreadPool&) = delete;
+
+	/// <summary>
+	/// 共有のスレッドプールを取得
+	/// </summary>
+	static ThreadPool* GetInstance();
+
+	/// <summary>
+	/// [0, count) をgrainSize個ずつに分けて並列に処理し、すべて終わるまで待ちます
+	/// 呼び出し元のスレッドも処理に参加します
+	/// ジョブの中から (ワーカーでも呼び出し元のスレッドでも) 呼ばれた場合は入れ子にせずその場で逐次実行します
+	/// </summary>
+	void ParallelFor(uint32_t count, uint32_t grainSize, const RangeFunc& func);
+
+	/// <summary>
+	/// 呼び出し元を含めた並列度
+	/// </summary>
+	uint32_t GetConcurrency() const {
+		return static_cast<uint32_t>(workers_.size()) + 1;
+	}
+
+private:
+	void WorkerLoop();
+	void RunChunks();
+
+	std::vector<std::thread> workers_;
+
+	std::mutex mutex_;
+	std::condition_variable wake_;
+	std::condition_variable done_;
+
+	// 実行中のジョブ
+	const RangeFunc* job_ = nullptr;
+	uint32_t count_ = 0;
+	uint32_t grainSize_ = 1;
+	std::atomic<uint32_t> next_ = 0;
+	uint32_t busyWorkers_ = 0;
+	uint64_t generation_ = 0;
+
+	// ParallelForの同時呼び出しを直列化する
+	std::mutex submitMutex_;
+
+	bool stop_ = false;
+};
@@ -1,15 +1,18 @@
 #pragma once
+#include "Quaternion.h"
 #include "Vec3.h"
 
 struct Transform {
 	Vec3 position;
-	Vec3 rotation;
+	Quaternion rotation;
 	Vec3 scale;
 
-	Transform(Vec3 position, Vec3 rotation, Vec3 scale) : position(position), rotation(rotation), scale(scale) {}
+	Transform(Vec3 position, Quaternion rotation, Vec3 scale) : position(position), rotation(rotation), scale(scale) {}
 	Transform() {
 		position = Vec3::zero;
-		rotation = Vec3::zero;
+		rotation = Quaternion::Identity();
 		scale = Vec3::one;
 	}
+
+	bool operator==(const Transform& rhs) const = default;
 };
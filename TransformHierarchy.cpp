@@ -0,0 +1,241 @@
+#include "TransformHierarchy.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+
+#include "Profiler.h"
+#include "ThreadPool.h"
+
+namespace {
+	// これより少ないノード数ではスレッドに分けない
+	constexpr uint32_t kParallelThreshold = 1024;
+}
+
+uint32_t TransformHierarchy::Add(const Transform& local, const uint32_t parent) {
+	assert((parent == kNone || parent < GetCount()) && "Parent must already exist");
+
+	const uint32_t handle = GetCount();
+	locals_.push_back(local);
+	worlds_.push_back(Mat4::Identity());
+	parentSlots_.push_back(parent == kNone ? kNone : handleToSlot_[parent]);
+	dirty_.push_back(1);
+	updated_.push_back(0);
+	rootOfSlot_.push_back(0);
+	handleToSlot_.push_back(handle);
+	slotToHandle_.push_back(handle);
+	parentHandles_.push_back(parent);
+
+	needsSort_ = true;
+	return handle;
+}
+
+void TransformHierarchy::SetParent(const uint32_t node, const uint32_t parent) {
+#ifndef NDEBUG
+	// 自分の子孫を親にすると循環する
+	for (uint32_t ancestor = parent; ancestor != kNone; ancestor = parentHandles_[ancestor]) {
+		assert(ancestor != node && "Cycle in transform hierarchy");
+	}
+#endif
+
+	parentHandles_[node] = parent;
+	needsSort_ = true;
+}
+
+void TransformHierarchy::SetLocal(const uint32_t node, const Transform& local) {
+	const uint32_t slot = handleToSlot_[node];
+	if (locals_[slot] == local) {
+		return;
+	}
+
+	locals_[slot] = local;
+	dirty_[slot] = 1;
+	// 並べ替え待ちのときは並べ替えで全体が変更ありになる
+	if (!needsSort_) {
+		rootDirty_[rootOfSlot_[slot]] = 1;
+	}
+}
+
+void TransformHierarchy::UpdateWorldMatrices(ThreadPool* pool) {
+	PROFILE_ZONE("TransformHierarchy::UpdateWorldMatrices");
+
+	if (needsSort_) {
+		Sort();
+	}
+
+	const uint32_t rootCount = static_cast<uint32_t>(rootBegins_.size());
+	std::atomic<uint32_t> updatedCount = 0;
+
+	// 変更のない部分木は丸ごと飛ばす
+	const auto UpdateRoots = [&](const uint32_t begin, const uint32_t end) {
+		uint32_t count = 0;
+		for (uint32_t root = begin; root < end; ++root) {
+			if (rootDirty_[root]) {
+				count += UpdateRange(rootBegins_[root], rootEnds_[root]);
+				rootDirty_[root] = 0;
+				rootUpdated_[root] = 1;
+			} else if (rootUpdated_[root]) {
+				// 前回の計算済みの印だけ消す
+				std::fill(updated_.begin() + rootBegins_[root], updated_.begin() + rootEnds_[root], uint8_t(0));
+				rootUpdated_[root] = 0;
+			}
+		}
+		updatedCount.fetch_add(count, std::memory_order_relaxed);
+	};
+
+	if (pool == nullptr || rootCount < 2 || GetCount() < kParallelThreshold) {
+		UpdateRoots(0, rootCount);
+	} else {
+		// 部分木どうしは依存しないのでルート単位で配る
+		const uint32_t grainSize = std::max(1u, rootCount / (pool->GetConcurrency() * 4));
+		pool->ParallelFor(rootCount, grainSize, UpdateRoots);
+	}
+
+	updatedCount_ = updatedCount.load(std::memory_order_relaxed);
+}
+
+void TransformHierarchy::Clear() {
+	locals_.clear();
+	worlds_.clear();
+	parentSlots_.clear();
+	dirty_.clear();
+	updated_.clear();
+	rootOfSlot_.clear();
+	rootBegins_.clear();
+	rootEnds_.clear();
+	rootDirty_.clear();
+	rootUpdated_.clear();
+	handleToSlot_.clear();
+	slotToHandle_.clear();
+	parentHandles_.clear();
+	updatedCount_ = 0;
+	needsSort_ = false;
+}
+
+void TransformHierarchy::Sort() {
+	const uint32_t count = GetCount();
+
+	// 子の一覧をCSR形式で作る (ハンドル順)
+	std::vector<uint32_t> childStart(count + 1, 0);
+	for (uint32_t handle = 0; handle < count; ++handle) {
+		if (parentHandles_[handle] != kNone) {
+			++childStart[parentHandles_[handle] + 1];
+		}
+	}
+	for (uint32_t i = 0; i < count; ++i) {
+		childStart[i + 1] += childStart[i];
+	}
+	std::vector<uint32_t> children(childStart[count]);
+	std::vector<uint32_t> cursor(childStart.begin(), childStart.end() - 1);
+	for (uint32_t handle = 0; handle < count; ++handle) {
+		if (parentHandles_[handle] != kNone) {
+			children[cursor[parentHandles_[handle]]++] = handle;
+		}
+	}
+
+	// 深さ優先 (行きがけ順) に並べると部分木が連続する
+	std::vector<uint32_t> order;
+	order.reserve(count);
+	std::vector<uint32_t> stack;
+	rootBegins_.clear();
+	rootEnds_.clear();
+	for (uint32_t root = 0; root < count; ++root) {
+		if (parentHandles_[root] != kNone) {
+			continue;
+		}
+
+		rootBegins_.push_back(static_cast<uint32_t>(order.size()));
+		stack.push_back(root);
+		while (!stack.empty()) {
+			const uint32_t handle = stack.back();
+			stack.pop_back();
+			order.push_back(handle);
+			// 逆順に積んで子を追加順に取り出す
+			for (uint32_t c = childStart[handle + 1]; c > childStart[handle]; --c) {
+				stack.push_back(children[c - 1]);
+			}
+		}
+		rootEnds_.push_back(static_cast<uint32_t>(order.size()));
+	}
+	const uint32_t rootCount = static_cast<uint32_t>(rootBegins_.size());
+	assert(order.size() == count && "Cycle in transform hierarchy");
+
+	// 新しい並びに詰め替える
+	std::vector<Transform> locals(count);
+	std::vector<Mat4> worlds(count);
+	for (uint32_t slot = 0; slot < count; ++slot) {
+		const uint32_t handle = order[slot];
+		locals[slot] = locals_[handleToSlot_[handle]];
+		worlds[slot] = worlds_[handleToSlot_[handle]];
+	}
+	locals_ = std::move(locals);
+	worlds_ = std::move(worlds);
+
+	slotToHandle_ = std::move(order);
+	for (uint32_t slot = 0; slot < count; ++slot) {
+		handleToSlot_[slotToHandle_[slot]] = slot;
+	}
+	for (uint32_t slot = 0; slot < count; ++slot) {
+		const uint32_t parent = parentHandles_[slotToHandle_[slot]];
+		parentSlots_[slot] = parent == kNone ? kNone : handleToSlot_[parent];
+	}
+	for (uint32_t root = 0; root < rootCount; ++root) {
+		std::fill(rootOfSlot_.begin() + rootBegins_[root], rootOfSlot_.begin() + rootEnds_[root], root);
+	}
+
+	// 親子関係が変わったので全体を計算し直す
+	std::fill(dirty_.begin(), dirty_.end(), uint8_t(1));
+	std::fill(updated_.begin(), updated_.end(), uint8_t(0));
+	rootDirty_.assign(rootCount, 1);
+	rootUpdated_.assign(rootCount, 0);
+
+	needsSort_ = false;
+}
+
+uint32_t TransformHierarchy::UpdateRange(const uint32_t begin, const uint32_t end) {
+	// 計算し直すノードをkBlock個ためてローカル行列をまとめて作る
+	constexpr uint32_t kBlock = 8;
+	uint32_t slots[kBlock];
+	Vec3 scales[kBlock];
+	Quaternion rotations[kBlock];
+	Vec3 positions[kBlock];
+	Mat4 matrices[kBlock];
+	uint32_t pending = 0;
+
+	const auto Flush = [&] {
+		Mat4::AffineBatch(std::span(scales, pending), std::span(rotations, pending), std::span(positions, pending),
+			std::span(matrices, pending));
+		// 親は前のスロットにあり、同じブロックでも先に確定している
+		for (uint32_t i = 0; i < pending; ++i) {
+			const uint32_t parent = parentSlots_[slots[i]];
+			worlds_[slots[i]] = parent == kNone ? matrices[i] : matrices[i] * worlds_[parent];
+		}
+		pending = 0;
+	};
+
+	uint32_t count = 0;
+	for (uint32_t slot = begin; slot < end; ++slot) {
+		// 親は前のスロットにあるので、親を計算し直したかはもう分かっている
+		const uint32_t parent = parentSlots_[slot];
+		const bool changed = dirty_[slot] || (parent != kNone && updated_[parent]);
+		updated_[slot] = changed ? 1 : 0;
+		if (!changed) {
+			continue;
+		}
+
+		const Transform& local = locals_[slot];
+		slots[pending] = slot;
+		scales[pending] = local.scale;
+		rotations[pending] = local.rotation;
+		positions[pending] = local.position;
+		dirty_[slot] = 0;
+		++count;
+		if (++pending == kBlock) {
+			Flush();
+		}
+	}
+	if (pending > 0) {
+		Flush();
+	}
+	return count;
+}
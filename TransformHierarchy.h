@@ -0,0 +1,121 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+
+#include "Mat4.h"
+#include "Transform.h"
+
+class ThreadPool;
+
+/// <summary>
+/// 親子関係を添字で持つ平坦なトランスフォーム階層
+/// ノードは深さ優先の順に並べ替えて持つので、親は必ず子より前にあり、部分木は連続した範囲になります
+/// ワールド行列は先頭から1回なめるだけで計算できます
+/// ローカルが変わったノードとその子孫だけを計算し直します
+/// </summary>
+class TransformHierarchy {
+public:
+	// 親がないことを表すハンドル
+	static constexpr uint32_t kNone = UINT32_MAX;
+
+	/// <summary>
+	/// ノードを追加します
+	/// </summary>
+	/// <param name="parent">親のハンドル (kNoneならルート)</param>
+	/// <returns>ノードのハンドル (並べ替えても変わりません)</returns>
+	uint32_t Add(const Transform& local, uint32_t parent = kNone);
+
+	/// <summary>
+	/// 親を付け替えます (次の更新で並べ替えます)
+	/// </summary>
+	void SetParent(uint32_t node, uint32_t parent);
+
+	uint32_t GetParent(const uint32_t node) const {
+		return parentHandles_[node];
+	}
+
+	/// <summary>
+	/// 親に対するローカルのトランスフォーム
+	/// </summary>
+	const Transform& GetLocal(const uint32_t node) const {
+		return locals_[handleToSlot_[node]];
+	}
+
+	/// <summary>
+	/// ローカルのトランスフォームを設定します
+	/// 値が変わったときだけノードを変更ありにします
+	/// </summary>
+	void SetLocal(uint32_t node, const Transform& local);
+
+	/// <summary>
+	/// 直前のUpdateWorldMatricesでワールド行列が計算し直されたか
+	/// (自分か祖先のローカルが変わった)
+	/// </summary>
+	bool WasUpdated(const uint32_t node) const {
+		return updated_[handleToSlot_[node]] != 0;
+	}
+
+	/// <summary>
+	/// 直前のUpdateWorldMatricesで計算し直したノード数
+	/// </summary>
+	uint32_t GetUpdatedCount() const {
+		return updatedCount_;
+	}
+
+	/// <summary>
+	/// 直前のUpdateWorldMatricesで計算したワールド行列
+	/// </summary>
+	const Mat4& GetWorldMatrix(const uint32_t node) const {
+		return worlds_[handleToSlot_[node]];
+	}
+
+	/// <summary>
+	/// すべてのワールド行列を親から順に計算します
+	/// poolを渡すとルートの部分木ごとにスレッドへ分けます
+	/// </summary>
+	void UpdateWorldMatrices(ThreadPool* pool = nullptr);
+
+	uint32_t GetCount() const {
+		return static_cast<uint32_t>(locals_.size());
+	}
+
+	void Clear();
+
+private:
+	/// <summary>
+	/// 深さ優先の順に並べ替え、部分木の範囲を求めます
+	/// </summary>
+	void Sort();
+
+	/// <summary>
+	/// [begin, end) のうち変更のあったノードと子孫のワールド行列を計算します
+	/// (範囲内の親は範囲の前か範囲内にあること)
+	/// </summary>
+	/// <returns>計算し直したノード数</returns>
+	uint32_t UpdateRange(uint32_t begin, uint32_t end);
+
+	// ここから下は並べ替え後の順 (スロット) で持つ
+	std::vector<Transform> locals_;
+	std::vector<Mat4> worlds_;
+	std::vector<uint32_t> parentSlots_;
+	// 自分のローカルが変わった (1) / 直前の更新で計算し直した (1)
+	std::vector<uint8_t> dirty_;
+	std::vector<uint8_t> updated_;
+	// 属するルートの番号
+	std::vector<uint32_t> rootOfSlot_;
+
+	// ルートのスロットと、その部分木の終わり (1つ先)
+	std::vector<uint32_t> rootBegins_;
+	std::vector<uint32_t> rootEnds_;
+	// 部分木に変更ありのノードがあるか / 直前の更新で部分木を計算したか
+	std::vector<uint8_t> rootDirty_;
+	std::vector<uint8_t> rootUpdated_;
+
+	// ハンドルとスロットの対応
+	std::vector<uint32_t> handleToSlot_;
+	std::vector<uint32_t> slotToHandle_;
+	std::vector<uint32_t> parentHandles_;
+
+	uint32_t updatedCount_ = 0;
+	bool needsSort_ = false;
+};
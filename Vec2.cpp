@@ -1,7 +1,7 @@
 #include "Vec2.h"
 
 #include <cassert>
-#include <corecrt_math.h>
+#include <cmath>
 #include <stdexcept>
 
 const Vec2 Vec2::zero(0.0f, 0.0f);
@@ -19,7 +19,7 @@ float Vec2::SqrtLength() const {
 float Vec2::Length() const {
 	const float sqrtLength = SqrtLength();
 	if (sqrtLength > 0.0f) {
-		return sqrtf(sqrtLength);
+		return std::sqrt(sqrtLength);
 	}
 	return 0.0f;
 }
@@ -51,7 +51,7 @@ void Vec2::Normalize() {
 Vec2 Vec2::Normalized() const {
 	const float sqrtLength = SqrtLength();
 	if (sqrtLength > 0.0f) {
-		const float invertLength = 1.0f / sqrtf(sqrtLength);
+		const float invertLength = 1.0f / std::sqrt(sqrtLength);
 		return {x * invertLength, y * invertLength};
 	}
 	return zero;
@@ -1,51 +1,168 @@
 #pragma once
+#include <cassert>
+#include <cmath>
 
+// 演算はすべてヘッダー内のconstexpr関数なので、呼び出し側でインライン展開・SIMD化されます
 struct Vec3 final {
 	float x, y, z;
 
-	Vec3() : x(0.0f), y(0.0f), z(0.0f) {}
+	constexpr Vec3() : x(0.0f), y(0.0f), z(0.0f) {}
 
-	Vec3(const float x, const float y, const float z) : x(x), y(y), z(z) {}
+	constexpr Vec3(const float x, const float y, const float z) : x(x), y(y), z(z) {}
 
 	static const Vec3 zero;
 	static const Vec3 one;
 
 	/* -------- メンバ関数 -------- */
 
-	float SqrtLength() const;
-	float Length() const;
-	float DotProduct(const Vec3& other) const;
-	Vec3 CrossProduct(const Vec3& other) const;
-	float Distance(const Vec3& other) const;
+	/// <summary>
+	///	ベクトルの長さの2乗を返します
+	/// </summary>
+	constexpr float SqrtLength() const {
+		return x * x + y * y + z * z;
+	}
 
-	void Normalize();
-	Vec3 Normalized() const;
+	/// <summary>
+	/// ベクトルの長さを返します
+	/// </summary>
+	float Length() const {
+		return std::sqrt(SqrtLength());
+	}
 
-	static Vec3 Lerp(const Vec3& start, const Vec3& end, float t);
+	/// <summary>
+	/// otherとのDot積を返します
+	/// </summary>
+	constexpr float DotProduct(const Vec3& other) const {
+		return x * other.x + y * other.y + z * other.z;
+	}
+
+	/// <summary>
+	/// otherとのCross積を返します
+	/// </summary>
+	constexpr Vec3 CrossProduct(const Vec3& other) const {
+		return {y * other.z - z * other.y, z * other.x - x * other.z, x * other.y - y * other.x};
+	}
+
+	float Distance(const Vec3& other) const {
+		return (other - *this).Length();
+	}
+
+	/// <summary>
+	/// ノーマライズします
+	/// </summary>
+	void Normalize() {
+		*this = Normalized();
+	}
+
+	/// <summary>
+	/// ノーマライズされた値を返します (長さ0ならゼロベクトル)
+	/// </summary>
+	Vec3 Normalized() const {
+		const float sqrtLength = SqrtLength();
+		const float invertLength = sqrtLength > 0.0f ? 1.0f / std::sqrt(sqrtLength) : 0.0f;
+		return *this * invertLength;
+	}
+
+	/// <summary>
+	/// startからendの間を線形補間します
+	/// </summary>
+	/// <param name="start">開始位置</param>
+	/// <param name="end">終了位置</param>
+	/// <param name="t">0～1の値</param>
+	static constexpr Vec3 Lerp(const Vec3& start, const Vec3& end, const float t) {
+		return start + (end - start) * t;
+	}
 
 	/* -------- 演算子 -------- */
-	float& operator[](int index);
-	const float& operator[](int index) const;
+
+	/// <summary>
+	/// 添字演算子 (メンバへのポインタの表で引くので分岐しません)
+	/// </summary>
+	constexpr float& operator[](const int index) {
+		assert(index <= 2 && index >= 0 && "Index out of range");
+		return this->*kElements[index];
+	}
+
+	/// <summary>
+	/// 添字演算子 (メンバへのポインタの表で引くので分岐しません)
+	/// </summary>
+	constexpr const float& operator[](const int index) const {
+		assert(index <= 2 && index >= 0 && "Index out of range");
+		return this->*kElements[index];
+	}
 
 	// スカラー
-	Vec3 operator+(const float& rhs) const;
-	Vec3 operator-(const float& rhs) const;
-	Vec3 operator*(const float& rhs) const;
-	Vec3 operator/(const float& rhs) const;
+	constexpr Vec3 operator+(const float& rhs) const {
+		return {x + rhs, y + rhs, z + rhs};
+	}
+
+	constexpr Vec3 operator-(const float& rhs) const {
+		return {x - rhs, y - rhs, z - rhs};
+	}
+
+	constexpr Vec3 operator*(const float& rhs) const {
+		return {x * rhs, y * rhs, z * rhs};
+	}
+
+	constexpr Vec3 operator/(const float& rhs) const {
+		return {x / rhs, y / rhs, z / rhs};
+	}
+
+	constexpr Vec3& operator+=(const float& rhs) {
+		return *this = *this + rhs;
+	}
+
+	constexpr Vec3& operator-=(const float& rhs) {
+		return *this = *this - rhs;
+	}
 
-	Vec3& operator+=(const float& rhs);
-	Vec3& operator-=(const float& rhs);
-	Vec3& operator*=(const float& rhs);
-	Vec3& operator/=(const float& rhs);
+	constexpr Vec3& operator*=(const float& rhs) {
+		return *this = *this * rhs;
+	}
+
+	constexpr Vec3& operator/=(const float& rhs) {
+		return *this = *this / rhs;
+	}
 
 	// ベクトル
-	Vec3 operator+(const Vec3& rhs) const;
-	Vec3 operator-(const Vec3& rhs) const;
-	Vec3 operator*(const Vec3& rhs) const;
-	Vec3 operator/(const Vec3& rhs) const;
-
-	Vec3& operator+=(const Vec3& rhs);
-	Vec3& operator-=(const Vec3& rhs);
-	Vec3& operator*=(const Vec3& rhs);
-	Vec3& operator/=(const Vec3& rhs);
+	constexpr Vec3 operator+(const Vec3& rhs) const {
+		return {x + rhs.x, y + rhs.y, z + rhs.z};
+	}
+
+	constexpr Vec3 operator-(const Vec3& rhs) const {
+		return {x - rhs.x, y - rhs.y, z - rhs.z};
+	}
+
+	constexpr Vec3 operator*(const Vec3& rhs) const {
+		return {x * rhs.x, y * rhs.y, z * rhs.z};
+	}
+
+	constexpr Vec3 operator/(const Vec3& rhs) const {
+		return {x / rhs.x, y / rhs.y, z / rhs.z};
+	}
+
+	constexpr Vec3& operator+=(const Vec3& rhs) {
+		return *this = *this + rhs;
+	}
+
+	constexpr Vec3& operator-=(const Vec3& rhs) {
+		return *this = *this - rhs;
+	}
+
+	constexpr Vec3& operator*=(const Vec3& rhs) {
+		return *this = *this * rhs;
+	}
+
+	constexpr Vec3& operator/=(const Vec3& rhs) {
+		return *this = *this / rhs;
+	}
+
+	// 比較 (完全一致)
+	bool operator==(const Vec3& rhs) const = default;
+
+private:
+	static constexpr float Vec3::* kElements[3] = {&Vec3::x, &Vec3::y, &Vec3::z};
 };
+
+inline constexpr Vec3 Vec3::zero(0.0f, 0.0f, 0.0f);
+inline constexpr Vec3 Vec3::one(1.0f, 1.0f, 1.0f);
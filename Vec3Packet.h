@@ -0,0 +1,527 @@
+#pragma once
+#include <cmath>
+#include <cstdint>
+
+#include "Vec3.h"
+
+// パケットの実装はコンパイル時に選びます
+// 8幅はAVXが使えればAVX、4幅はSSEが使えればSSE、それ以外は分岐のないスカラーのループ (コンパイラがSIMD化します)
+#if defined(__AVX__)
+#define PACKET_AVX
+#include <immintrin.h>
+#endif
+#if defined(_M_X64) || defined(_M_IX86) || defined(__SSE2__)
+#define PACKET_SSE
+#include <emmintrin.h>
+#endif
+
+template <uint32_t N>
+struct FloatPacket;
+
+/// <summary>
+/// レーンごとの真偽 (スカラー実装)
+/// </summary>
+template <uint32_t N>
+struct MaskPacket {
+	bool v[N];
+
+	MaskPacket operator&(const MaskPacket& rhs) const {
+		MaskPacket result;
+		for (uint32_t i = 0; i < N; ++i) {
+			result.v[i] = v[i] && rhs.v[i];
+		}
+		return result;
+	}
+
+	MaskPacket operator|(const MaskPacket& rhs) const {
+		MaskPacket result;
+		for (uint32_t i = 0; i < N; ++i) {
+			result.v[i] = v[i] || rhs.v[i];
+		}
+		return result;
+	}
+
+	MaskPacket operator!() const {
+		MaskPacket result;
+		for (uint32_t i = 0; i < N; ++i) {
+			result.v[i] = !v[i];
+		}
+		return result;
+	}
+
+	/// <summary>
+	/// どれかのレーンが真か
+	/// </summary>
+	bool Any() const {
+		bool any = false;
+		for (uint32_t i = 0; i < N; ++i) {
+			any = any || v[i];
+		}
+		return any;
+	}
+};
+
+/// <summary>
+/// N個のfloatを同時に計算するパケット (スカラー実装)
+/// </summary>
+template <uint32_t N>
+struct FloatPacket {
+	using Mask = MaskPacket<N>;
+
+	float v[N];
+
+	FloatPacket() = default;
+
+	// 全レーンに同じ値を入れる
+	FloatPacket(const float value) {
+		for (uint32_t i = 0; i < N; ++i) {
+			v[i] = value;
+		}
+	}
+
+	static FloatPacket Load(const float* source) {
+		FloatPacket result;
+		for (uint32_t i = 0; i < N; ++i) {
+			result.v[i] = source[i];
+		}
+		return result;
+	}
+
+	void Store(float* destination) const {
+		for (uint32_t i = 0; i < N; ++i) {
+			destination[i] = v[i];
+		}
+	}
+
+	float operator[](const uint32_t lane) const {
+		return v[lane];
+	}
+
+#define PACKET_BINARY(op)                                                                                             \
+	FloatPacket operator op(const FloatPacket& rhs) const {                                                           \
+		FloatPacket result;                                                                                           \
+		for (uint32_t i = 0; i < N; ++i) {                                                                            \
+			result.v[i] = v[i] op rhs.v[i];                                                                           \
+		}                                                                                                             \
+		return result;                                                                                                \
+	}
+	PACKET_BINARY(+)
+	PACKET_BINARY(-)
+	PACKET_BINARY(*)
+	PACKET_BINARY(/)
+#undef PACKET_BINARY
+
+#define PACKET_COMPARE(op)                                                                                            \
+	Mask operator op(const FloatPacket& rhs) const {                                                                  \
+		Mask result;                                                                                                  \
+		for (uint32_t i = 0; i < N; ++i) {                                                                            \
+			result.v[i] = v[i] op rhs.v[i];                                                                           \
+		}                                                                                                             \
+		return result;                                                                                                \
+	}
+	PACKET_COMPARE(<)
+	PACKET_COMPARE(<=)
+	PACKET_COMPARE(>)
+	PACKET_COMPARE(>=)
+#undef PACKET_COMPARE
+
+	FloatPacket operator-() const {
+		FloatPacket result;
+		for (uint32_t i = 0; i < N; ++i) {
+			result.v[i] = -v[i];
+		}
+		return result;
+	}
+
+	friend FloatPacket Min(const FloatPacket& a, const FloatPacket& b) {
+		FloatPacket result;
+		for (uint32_t i = 0; i < N; ++i) {
+			result.v[i] = b.v[i] < a.v[i] ? b.v[i] : a.v[i];
+		}
+		return result;
+	}
+
+	friend FloatPacket Max(const FloatPacket& a, const FloatPacket& b) {
+		FloatPacket result;
+		for (uint32_t i = 0; i < N; ++i) {
+			result.v[i] = a.v[i] < b.v[i] ? b.v[i] : a.v[i];
+		}
+		return result;
+	}
+
+	friend FloatPacket Sqrt(const FloatPacket& a) {
+		FloatPacket result;
+		for (uint32_t i = 0; i < N; ++i) {
+			result.v[i] = std::sqrt(a.v[i]);
+		}
+		return result;
+	}
+
+	/// <summary>
+	/// maskが真のレーンはa、偽のレーンはb
+	/// </summary>
+	friend FloatPacket Select(const Mask& mask, const FloatPacket& a, const FloatPacket& b) {
+		FloatPacket result;
+		for (uint32_t i = 0; i < N; ++i) {
+			result.v[i] = mask.v[i] ? a.v[i] : b.v[i];
+		}
+		return result;
+	}
+};
+
+#ifdef PACKET_SSE
+/// <summary>
+/// 4レーンの真偽 (SSE)
+/// </summary>
+template <>
+struct MaskPacket<4> {
+	__m128 v;
+
+	MaskPacket operator&(const MaskPacket& rhs) const {
+		return {_mm_and_ps(v, rhs.v)};
+	}
+
+	MaskPacket operator|(const MaskPacket& rhs) const {
+		return {_mm_or_ps(v, rhs.v)};
+	}
+
+	MaskPacket operator!() const {
+		return {_mm_xor_ps(v, _mm_castsi128_ps(_mm_set1_epi32(-1)))};
+	}
+
+	bool Any() const {
+		return _mm_movemask_ps(v) != 0;
+	}
+};
+
+/// <summary>
+/// 4個のfloatを同時に計算するパケット (SSE)
+/// </summary>
+template <>
+struct FloatPacket<4> {
+	using Mask = MaskPacket<4>;
+
+	__m128 v;
+
+	FloatPacket() = default;
+
+	FloatPacket(const __m128 value) : v(value) {}
+
+	FloatPacket(const float value) : v(_mm_set1_ps(value)) {}
+
+	static FloatPacket Load(const float* source) {
+		return _mm_loadu_ps(source);
+	}
+
+	void Store(float* destination) const {
+		_mm_storeu_ps(destination, v);
+	}
+
+	float operator[](const uint32_t lane) const {
+		alignas(16) float lanes[4];
+		_mm_store_ps(lanes, v);
+		return lanes[lane];
+	}
+
+	FloatPacket operator+(const FloatPacket& rhs) const { return _mm_add_ps(v, rhs.v); }
+	FloatPacket operator-(const FloatPacket& rhs) const { return _mm_sub_ps(v, rhs.v); }
+	FloatPacket operator*(const FloatPacket& rhs) const { return _mm_mul_ps(v, rhs.v); }
+	FloatPacket operator/(const FloatPacket& rhs) const { return _mm_div_ps(v, rhs.v); }
+
+	Mask operator<(const FloatPacket& rhs) const { return {_mm_cmplt_ps(v, rhs.v)}; }
+	Mask operator<=(const FloatPacket& rhs) const { return {_mm_cmple_ps(v, rhs.v)}; }
+	Mask operator>(const FloatPacket& rhs) const { return {_mm_cmpgt_ps(v, rhs.v)}; }
+	Mask operator>=(const FloatPacket& rhs) const { return {_mm_cmpge_ps(v, rhs.v)}; }
+
+	FloatPacket operator-() const {
+		return _mm_xor_ps(v, _mm_set1_ps(-0.0f));
+	}
+
+	// minps/maxpsは比較が偽なら2番目を返すので、スカラー実装の式と結果が一致する
+	friend FloatPacket Min(const FloatPacket& a, const FloatPacket& b) { return _mm_min_ps(b.v, a.v); }
+	friend FloatPacket Max(const FloatPacket& a, const FloatPacket& b) { return _mm_max_ps(b.v, a.v); }
+	friend FloatPacket Sqrt(const FloatPacket& a) { return _mm_sqrt_ps(a.v); }
+
+	friend FloatPacket Select(const Mask& mask, const FloatPacket& a, const FloatPacket& b) {
+		return _mm_or_ps(_mm_and_ps(mask.v, a.v), _mm_andnot_ps(mask.v, b.v));
+	}
+};
+#endif
+
+#ifdef PACKET_AVX
+/// <summary>
+/// 8レーンの真偽 (AVX)
+/// </summary>
+template <>
+struct MaskPacket<8> {
+	__m256 v;
+
+	MaskPacket operator&(const MaskPacket& rhs) const {
+		return {_mm256_and_ps(v, rhs.v)};
+	}
+
+	MaskPacket operator|(const MaskPacket& rhs) const {
+		return {_mm256_or_ps(v, rhs.v)};
+	}
+
+	MaskPacket operator!() const {
+		return {_mm256_xor_ps(v, _mm256_castsi256_ps(_mm256_set1_epi32(-1)))};
+	}
+
+	bool Any() const {
+		return _mm256_movemask_ps(v) != 0;
+	}
+};
+
+/// <summary>
+/// 8個のfloatを同時に計算するパケット (AVX)
+/// </summary>
+template <>
+struct FloatPacket<8> {
+	using Mask = MaskPacket<8>;
+
+	__m256 v;
+
+	FloatPacket() = default;
+
+	FloatPacket(const __m256 value) : v(value) {}
+
+	FloatPacket(const float value) : v(_mm256_set1_ps(value)) {}
+
+	static FloatPacket Load(const float* source) {
+		return _mm256_loadu_ps(source);
+	}
+
+	void Store(float* destination) const {
+		_mm256_storeu_ps(destination, v);
+	}
+
+	float operator[](const uint32_t lane) const {
+		alignas(32) float lanes[8];
+		_mm256_store_ps(lanes, v);
+		return lanes[lane];
+	}
+
+	FloatPacket operator+(const FloatPacket& rhs) const { return _mm256_add_ps(v, rhs.v); }
+	FloatPacket operator-(const FloatPacket& rhs) const { return _mm256_sub_ps(v, rhs.v); }
+	FloatPacket operator*(const FloatPacket& rhs) const { return _mm256_mul_ps(v, rhs.v); }
+	FloatPacket operator/(const FloatPacket& rhs) const { return _mm256_div_ps(v, rhs.v); }
+
+	Mask operator<(const FloatPacket& rhs) const { return {_mm256_cmp_ps(v, rhs.v, _CMP_LT_OQ)}; }
+	Mask operator<=(const FloatPacket& rhs) const { return {_mm256_cmp_ps(v, rhs.v, _CMP_LE_OQ)}; }
+	Mask operator>(const FloatPacket& rhs) const { return {_mm256_cmp_ps(v, rhs.v, _CMP_GT_OQ)}; }
+	Mask operator>=(const FloatPacket& rhs) const { return {_mm256_cmp_ps(v, rhs.v, _CMP_GE_OQ)}; }
+
+	FloatPacket operator-() const {
+		return _mm256_xor_ps(v, _mm256_set1_ps(-0.0f));
+	}
+
+	friend FloatPacket Min(const FloatPacket& a, const FloatPacket& b) { return _mm256_min_ps(b.v, a.v); }
+	friend FloatPacket Max(const FloatPacket& a, const FloatPacket& b) { return _mm256_max_ps(b.v, a.v); }
+	friend FloatPacket Sqrt(const FloatPacket& a) { return _mm256_sqrt_ps(a.v); }
+
+	friend FloatPacket Select(const Mask& mask, const FloatPacket& a, const FloatPacket& b) {
+		return _mm256_blendv_ps(b.v, a.v, mask.v);
+	}
+};
+#endif
+
+/// <summary>
+/// N個のVec3を成分ごとに並べて同時に計算するパケット (x[N], y[N], z[N])
+/// 操作はVec3と同じ名前でそろえています
+/// </summary>
+template <uint32_t N>
+struct Vec3Packet {
+	using Float = FloatPacket<N>;
+	using Mask = MaskPacket<N>;
+
+	Float x, y, z;
+
+	Vec3Packet() = default;
+
+	Vec3Packet(const Float& x, const Float& y, const Float& z) : x(x), y(y), z(z) {}
+
+	// 全レーンに同じベクトルを入れる
+	explicit Vec3Packet(const Vec3& value) : x(value.x), y(value.y), z(value.z) {}
+
+	/// <summary>
+	/// 成分ごとの配列 (SoA) から読み込みます
+	/// </summary>
+	static Vec3Packet Load(const float* sourceX, const float* sourceY, const float* sourceZ) {
+		return {Float::Load(sourceX), Float::Load(sourceY), Float::Load(sourceZ)};
+	}
+
+	void Store(float* destinationX, float* destinationY, float* destinationZ) const {
+		x.Store(destinationX);
+		y.Store(destinationY);
+		z.Store(destinationZ);
+	}
+
+	/// <summary>
+	/// 連続したN個のVec3 (BodyArraysの配列など) を読み込みます
+	/// </summary>
+	static Vec3Packet Load(const Vec3* source) {
+#ifdef PACKET_SSE
+		// 4個ずつシャッフルで成分ごとに並べ替える
+		if constexpr (N == 4) {
+			__m128 x4, y4, z4;
+			Deinterleave4(&source->x, x4, y4, z4);
+			return {x4, y4, z4};
+		}
+#endif
+#ifdef PACKET_AVX
+		if constexpr (N == 8) {
+			__m128 x0, y0, z0, x1, y1, z1;
+			Deinterleave4(&source->x, x0, y0, z0);
+			Deinterleave4(&source[4].x, x1, y1, z1);
+			return {_mm256_set_m128(x1, x0), _mm256_set_m128(y1, y0), _mm256_set_m128(z1, z0)};
+		}
+#endif
+		alignas(32) float lanes[3][N];
+		for (uint32_t i = 0; i < N; ++i) {
+			lanes[0][i] = source[i].x;
+			lanes[1][i] = source[i].y;
+			lanes[2][i] = source[i].z;
+		}
+		return Load(lanes[0], lanes[1], lanes[2]);
+	}
+
+	void Store(Vec3* destination) const {
+#ifdef PACKET_SSE
+		if constexpr (N == 4) {
+			Interleave4(x.v, y.v, z.v, &destination->x);
+			return;
+		}
+#endif
+#ifdef PACKET_AVX
+		if constexpr (N == 8) {
+			Interleave4(_mm256_castps256_ps128(x.v), _mm256_castps256_ps128(y.v), _mm256_castps256_ps128(z.v),
+				&destination->x);
+			Interleave4(_mm256_extractf128_ps(x.v, 1), _mm256_extractf128_ps(y.v, 1), _mm256_extractf128_ps(z.v, 1),
+				&destination[4].x);
+			return;
+		}
+#endif
+		alignas(32) float lanes[3][N];
+		Store(lanes[0], lanes[1], lanes[2]);
+		for (uint32_t i = 0; i < N; ++i) {
+			destination[i] = {lanes[0][i], lanes[1][i], lanes[2][i]};
+		}
+	}
+
+	Vec3 operator[](const uint32_t lane) const {
+		return {x[lane], y[lane], z[lane]};
+	}
+
+	/* -------- メンバ関数 -------- */
+
+	/// <summary>
+	/// 長さの2乗
+	/// </summary>
+	Float SqrtLength() const {
+		return x * x + y * y + z * z;
+	}
+
+	Float Length() const {
+		return Sqrt(SqrtLength());
+	}
+
+	Float DotProduct(const Vec3Packet& other) const {
+		return x * other.x + y * other.y + z * other.z;
+	}
+
+	Vec3Packet CrossProduct(const Vec3Packet& other) const {
+		return {y * other.z - z * other.y, z * other.x - x * other.z, x * other.y - y * other.x};
+	}
+
+	/// <summary>
+	/// 正規化した値を返します (長さ0のレーンはゼロベクトル)
+	/// </summary>
+	Vec3Packet Normalized() const {
+		const Float sqrtLength = SqrtLength();
+		const Float invertLength = Select(sqrtLength > Float(0.0f), Float(1.0f) / Sqrt(sqrtLength), Float(0.0f));
+		return *this * invertLength;
+	}
+
+	static Vec3Packet Lerp(const Vec3Packet& start, const Vec3Packet& end, const Float& t) {
+		return start + (end - start) * t;
+	}
+
+	/// <summary>
+	/// maskが真のレーンはa、偽のレーンはb
+	/// </summary>
+	friend Vec3Packet Select(const Mask& mask, const Vec3Packet& a, const Vec3Packet& b) {
+		return {Select(mask, a.x, b.x), Select(mask, a.y, b.y), Select(mask, a.z, b.z)};
+	}
+
+	/* -------- 演算子 -------- */
+
+	Vec3Packet operator+(const Vec3Packet& rhs) const {
+		return {x + rhs.x, y + rhs.y, z + rhs.z};
+	}
+
+	Vec3Packet operator-(const Vec3Packet& rhs) const {
+		return {x - rhs.x, y - rhs.y, z - rhs.z};
+	}
+
+	Vec3Packet operator*(const Float& rhs) const {
+		return {x * rhs, y * rhs, z * rhs};
+	}
+
+	Vec3Packet& operator+=(const Vec3Packet& rhs) {
+		return *this = *this + rhs;
+	}
+
+	Vec3Packet& operator-=(const Vec3Packet& rhs) {
+		return *this = *this - rhs;
+	}
+
+private:
+#ifdef PACKET_SSE
+	// Vec3は3つのfloatが隙間なく並ぶので、4個 = 12個のfloatをレジスタ3本で読み書きできる
+	static_assert(sizeof(Vec3) == sizeof(float) * 3);
+
+	/// <summary>
+	/// x0 y0 z0 x1 | y1 z1 x2 y2 | z2 x3 y3 z3 を成分ごとに分けます
+	/// </summary>
+	static void Deinterleave4(const float* source, __m128& outX, __m128& outY, __m128& outZ) {
+		const __m128 a = _mm_loadu_ps(source);
+		const __m128 b = _mm_loadu_ps(source + 4);
+		const __m128 c = _mm_loadu_ps(source + 8);
+		const __m128 b2c1 = _mm_shuffle_ps(b, c, _MM_SHUFFLE(1, 1, 2, 2));
+		const __m128 a1b0 = _mm_shuffle_ps(a, b, _MM_SHUFFLE(0, 0, 1, 1));
+		const __m128 b3c2 = _mm_shuffle_ps(b, c, _MM_SHUFFLE(2, 2, 3, 3));
+		const __m128 a2b1 = _mm_shuffle_ps(a, b, _MM_SHUFFLE(1, 1, 2, 2));
+		outX = _mm_shuffle_ps(a, b2c1, _MM_SHUFFLE(2, 0, 3, 0));
+		outY = _mm_shuffle_ps(a1b0, b3c2, _MM_SHUFFLE(2, 0, 2, 0));
+		outZ = _mm_shuffle_ps(a2b1, c, _MM_SHUFFLE(3, 0, 2, 0));
+	}
+
+	/// <summary>
+	/// Deinterleave4の逆
+	/// </summary>
+	static void Interleave4(const __m128 x, const __m128 y, const __m128 z, float* destination) {
+		const __m128 x0y0 = _mm_shuffle_ps(x, y, _MM_SHUFFLE(0, 0, 0, 0));
+		const __m128 z0x1 = _mm_shuffle_ps(z, x, _MM_SHUFFLE(1, 1, 0, 0));
+		const __m128 y1z1 = _mm_shuffle_ps(y, z, _MM_SHUFFLE(1, 1, 1, 1));
+		const __m128 x2y2 = _mm_shuffle_ps(x, y, _MM_SHUFFLE(2, 2, 2, 2));
+		const __m128 z2x3 = _mm_shuffle_ps(z, x, _MM_SHUFFLE(3, 3, 2, 2));
+		const __m128 y3z3 = _mm_shuffle_ps(y, z, _MM_SHUFFLE(3, 3, 3, 3));
+		_mm_storeu_ps(destination, _mm_shuffle_ps(x0y0, z0x1, _MM_SHUFFLE(2, 0, 2, 0)));
+		_mm_storeu_ps(destination + 4, _mm_shuffle_ps(y1z1, x2y2, _MM_SHUFFLE(2, 0, 2, 0)));
+		_mm_storeu_ps(destination + 8, _mm_shuffle_ps(z2x3, y3z3, _MM_SHUFFLE(2, 0, 2, 0)));
+	}
+#endif
+};
+
+using Float4 = FloatPacket<4>;
+using Float8 = FloatPacket<8>;
+using Vec3x4 = Vec3Packet<4>;
+using Vec3x8 = Vec3Packet<8>;
+
+// レジスタ1本に収まる幅 (配列をまとめて処理するカーネルはこの幅で回す)
+#ifdef PACKET_AVX
+inline constexpr uint32_t kNativePacketWidth = 8;
+#else
+inline constexpr uint32_t kNativePacketWidth = 4;
+#endif
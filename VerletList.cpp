@@ -0,0 +1,85 @@
+#include "VerletList.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "Profiler.h"
+
+bool VerletList::FindPairs(const std::span<const Vec3> positions, const std::span<const float> radii, const float skin,
+	std::vector<BodyPair>& outPairs, const CollisionFilter* filter) {
+	PROFILE_ZONE("VerletList::FindPairs");
+
+	const bool rebuild = MeasureDisplacements(positions, radii, skin);
+	if (rebuild) {
+		Rebuild(positions, radii, skin, filter);
+	}
+
+	// 候補を先頭からなめるだけ
+	outPairs.clear();
+	skippedCount_ = 0;
+	const uint32_t candidateCount = GetCandidateCount();
+	for (uint32_t k = 0; k < candidateCount; ++k) {
+		const BodyPair& pair = candidates_[k];
+		// 隙間を測ってから2つの球が動けた距離は、そのときと今の変位の和以下
+		// それが隙間に届かなければまだ離れている
+		const float displacement = displacements_[pair.a] + displacements_[pair.b];
+		if (displacement < closingDisplacements_[k]) {
+			++skippedCount_;
+			continue;
+		}
+
+		const float radiusSum = radii[pair.a] + radii[pair.b];
+		const float sqrDistance = (positions[pair.b] - positions[pair.a]).SqrtLength();
+		if (sqrDistance < radiusSum * radiusSum) {
+			outPairs.push_back(pair);
+		} else {
+			closingDisplacements_[k] = std::sqrt(sqrDistance) - radiusSum - displacement;
+		}
+	}
+
+	return rebuild;
+}
+
+bool VerletList::MeasureDisplacements(const std::span<const Vec3> positions, const std::span<const float> radii,
+	const float skin) {
+	if (!valid_ || skin != builtSkin_ || positions.size() != builtPositions_.size()) {
+		return true;
+	}
+
+	// 2つの球の変位の和がスキンを超えなければ、候補にない組は重ならない
+	const float halfSkin = skin * 0.5f;
+	const uint32_t count = static_cast<uint32_t>(positions.size());
+	for (uint32_t i = 0; i < count; ++i) {
+		const float displacement = (positions[i] - builtPositions_[i]).Length() + std::fabs(radii[i] - builtRadii_[i]);
+		if (displacement > halfSkin) {
+			return true;
+		}
+		displacements_[i] = displacement;
+	}
+	return false;
+}
+
+void VerletList::Rebuild(const std::span<const Vec3> positions, const std::span<const float> radii, const float skin,
+	const CollisionFilter* filter) {
+	PROFILE_ZONE("VerletList::Rebuild");
+
+	builtPositions_.assign(positions.begin(), positions.end());
+	builtRadii_.assign(radii.begin(), radii.end());
+	builtSkin_ = skin;
+
+	// 半径を半分ずつ膨らませれば、グリッドが中心間の距離 < 半径の和 + skin の組を出す
+	inflatedRadii_.resize(radii.size());
+	std::transform(radii.begin(), radii.end(), inflatedRadii_.begin(), [skin](const float radius) {
+		return radius + skin * 0.5f;
+	});
+	grid_.Build(positions, inflatedRadii_);
+	// 衝突させない組は候補に入れないので、使い回す間は判定もしない
+	grid_.FindPairs(candidates_, filter);
+
+	// 隙間は最初のFindPairsで測る
+	displacements_.assign(positions.size(), 0.0f);
+	closingDisplacements_.assign(candidates_.size(), 0.0f);
+
+	++rebuildCount_;
+	valid_ = true;
+}
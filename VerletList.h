@@ -0,0 +1,84 @@
+#pragma once
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include "SpatialGrid.h"
+#include "Vec3.h"
+
+struct CollisionFilter;
+
+/// <summary>
+/// スキン付きの近傍リスト (分子動力学のVerletリスト)
+/// 半径にスキンを足して候補ペアを作っておき、どれかの剛体が作ったときからスキンの半分以上
+/// 動く (または半径が大きくなる) までは作り直さずに使い回します
+/// 作り直さないステップは候補の配列を先頭からなめて球の重なりを見るだけになります
+/// 離れていた候補は隙間を覚えておき、2つの球の移動量の和がその隙間に届きうるまでは判定も飛ばします
+/// 動きの遅い密なシーン (粒体の山など) 向けです
+/// </summary>
+class VerletList {
+public:
+	/// <summary>
+	/// 必要なら候補を作り直し、球同士が重なっているペアを列挙します (SpatialGrid::FindPairsと同じ条件)
+	/// </summary>
+	/// <param name="skin">半径に足す余裕 (2つの球の間で合わせてこの距離)</param>
+	/// <param name="filter">作り直すときに衝突させない組を候補から除きます (変えたらInvalidateすること)</param>
+	/// <returns>候補を作り直したらtrue</returns>
+	bool FindPairs(std::span<const Vec3> positions, std::span<const float> radii, float skin,
+		std::vector<BodyPair>& outPairs, const CollisionFilter* filter = nullptr);
+
+	/// <summary>
+	/// 次のFindPairsで必ず作り直すようにします (剛体の並べ替えや追加、ふるい分けの条件を変えた後)
+	/// </summary>
+	void Invalidate() {
+		valid_ = false;
+	}
+
+	/// <summary>
+	/// 候補ペアの数
+	/// </summary>
+	uint32_t GetCandidateCount() const {
+		return static_cast<uint32_t>(candidates_.size());
+	}
+
+	/// <summary>
+	/// これまでに候補を作り直した回数
+	/// </summary>
+	uint32_t GetRebuildCount() const {
+		return rebuildCount_;
+	}
+
+	/// <summary>
+	/// 直前のFindPairsで隙間が閉じえないので判定を飛ばした候補の数
+	/// </summary>
+	uint32_t GetSkippedCount() const {
+		return skippedCount_;
+	}
+
+private:
+	/// <summary>
+	/// 作ったときからの剛体ごとの変位を求め、候補にない組が重なりうるほど動いたかを返します
+	/// </summary>
+	bool MeasureDisplacements(std::span<const Vec3> positions, std::span<const float> radii, float skin);
+
+	void Rebuild(std::span<const Vec3> positions, std::span<const float> radii, float skin,
+		const CollisionFilter* filter);
+
+	SpatialGrid grid_;
+	std::vector<BodyPair> candidates_;
+
+	// 作ったときの状態
+	std::vector<Vec3> builtPositions_;
+	std::vector<float> builtRadii_;
+	std::vector<float> inflatedRadii_;
+	float builtSkin_ = 0.0f;
+
+	// 作ったときからの変位 (移動距離 + 半径の変化)
+	std::vector<float> displacements_;
+	// 候補ごとに、両方の変位の和がこれに届くまでは重ならない (最後に測った隙間 - その時の和)
+	std::vector<float> closingDisplacements_;
+
+	uint32_t rebuildCount_ = 0;
+	uint32_t skippedCount_ = 0;
+	bool valid_ = false;
+};
@@ -0,0 +1,346 @@
+#include "WorldBatch.h"
+
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+#include <cmath>
+
+#include "CollisionFilter.h"
+#include "Vec3Packet.h"
+
+namespace {
+	static_assert(kBatchLanes == 8, "WorldBatch is written against 8-wide packets");
+
+	Float8 LoadLanes(const LaneFloat& lanes) {
+		return Float8::Load(lanes.v);
+	}
+
+	Vec3x8 LoadLanes(const LaneVec3& lanes) {
+		return Vec3x8::Load(lanes.x, lanes.y, lanes.z);
+	}
+
+	void StoreLanes(const Vec3x8& packet, LaneVec3& lanes) {
+		packet.Store(lanes.x, lanes.y, lanes.z);
+	}
+}
+
+void WorldBatch::Load(const std::span<const SceneDescription> scenes) {
+	assert(!scenes.empty() && scenes.size() <= kBatchLanes && "Scene count out of range");
+
+	worldCount_ = static_cast<uint32_t>(scenes.size());
+	const SceneDescription& first = scenes.front();
+	const uint32_t count = static_cast<uint32_t>(first.bodies.size());
+
+	positions_.assign(count, {});
+	velocities_.assign(count, {});
+	pseudoVelocities_.assign(count, {});
+	masses_.assign(count, {});
+	inverseMasses_.assign(count, {});
+	radii_.assign(count, {});
+	restitutions_.assign(count, {});
+	maxDistances_.assign(count, {});
+
+	parents_.resize(count);
+	for (uint32_t i = 0; i < count; ++i) {
+		parents_[i] = first.bodies[i].parent;
+	}
+
+	// 小さなシーンなので総当たりのペアをレーン全体で判定する
+	// 衝突させない組はここで除き、ステップでは判定しない
+	std::vector<uint32_t> layers(count);
+	std::vector<uint32_t> masks(count);
+	for (uint32_t i = 0; i < count; ++i) {
+		layers[i] = first.bodies[i].collisionLayer;
+		masks[i] = first.bodies[i].collisionMask;
+	}
+	CollisionFilter filter;
+	filter.layers = layers;
+	filter.masks = masks;
+	if (!first.settings.parentCollision) {
+		filter.parents = parents_;
+	}
+
+	// トリガーは重なりを知らせるだけでぶつからないので、ペアに入れない
+	pairs_.clear();
+	for (uint32_t i = 0; i < count; ++i) {
+		if (first.bodies[i].isTrigger) {
+			continue;
+		}
+		for (uint32_t j = i + 1; j < count; ++j) {
+			if (!first.bodies[j].isTrigger && filter.ShouldCollide(i, j)) {
+				pairs_.push_back({i, j});
+			}
+		}
+	}
+
+	for (uint32_t lane = 0; lane < kBatchLanes; ++lane) {
+		// 余ったレーンは先頭のシーンで埋めて結果は使わない
+		const SceneDescription& scene = lane < worldCount_ ? scenes[lane] : first;
+		assert(scene.bodies.size() == count && "All scenes must have the same body count");
+		// ペアは先頭のシーンのふるい分けで全レーン共通に作ったので、その条件もそろっている必要がある
+		assert(scene.settings.parentCollision == first.settings.parentCollision &&
+			"All scenes must have the same parentCollision");
+
+		for (uint32_t i = 0; i < count; ++i) {
+			const BodyDescription& body = scene.bodies[i];
+			assert(body.parent == parents_[i] && "All scenes must have the same hierarchy");
+			assert(body.collisionLayer == layers[i] && body.collisionMask == masks[i] &&
+				"All scenes must have the same collision layers and masks");
+			assert(body.isTrigger == first.bodies[i].isTrigger && "All scenes must have the same triggers");
+
+			const Vec3 velocity = body.isStatic ? Vec3::zero : body.velocity;
+			positions_[i].x[lane] = body.position.x;
+			positions_[i].y[lane] = body.position.y;
+			positions_[i].z[lane] = body.position.z;
+			velocities_[i].x[lane] = velocity.x;
+			velocities_[i].y[lane] = velocity.y;
+			velocities_[i].z[lane] = velocity.z;
+			masses_[i].v[lane] = body.mass;
+			inverseMasses_[i].v[lane] = body.isStatic ? 0.0f : 1.0f / body.mass;
+			radii_[i].v[lane] = body.radius;
+			restitutions_[i].v[lane] = body.restitution;
+
+			if (body.parent != kNoParent) {
+				maxDistances_[i].v[lane] = body.maxDistanceToParent >= 0.0f
+					? body.maxDistanceToParent
+					: body.position.Distance(scene.bodies[body.parent].position);
+			}
+		}
+
+		gravity_.x[lane] = scene.gravity.x;
+		gravity_.y[lane] = scene.gravity.y;
+		gravity_.z[lane] = scene.gravity.z;
+		linearDrag_.v[lane] = scene.linearDrag;
+		penetrationSlop_.v[lane] = scene.settings.penetrationSlop;
+		baumgarteFactor_.v[lane] = scene.settings.baumgarteFactor;
+		reductionFactor_.v[lane] = scene.settings.reductionFactor;
+	}
+
+	deltaTime_ = first.settings.deltaTime;
+	maxIterations_ = first.settings.maxIterations;
+	tolerance_ = first.settings.tolerance;
+
+	metrics_ = {};
+}
+
+void WorldBatch::Step() {
+	const auto start = std::chrono::steady_clock::now();
+
+	IntegrateVelocities();
+	SolveConstraints();
+	IntegratePositions();
+
+	const auto end = std::chrono::steady_clock::now();
+	metrics_.stepMilliseconds = std::chrono::duration<double, std::milli>(end - start).count();
+}
+
+LaneFloat WorldBatch::ComputeEnergy() const {
+	const Float8 zero = 0.0f;
+	const Float8 one = 1.0f;
+	Float8 energy = zero;
+	const Vec3x8 gravity = LoadLanes(gravity_);
+	for (uint32_t i = 0; i < GetBodyCount(); ++i) {
+		const Vec3x8 p = LoadLanes(positions_[i]);
+		const Vec3x8 v = LoadLanes(velocities_[i]);
+		const Float8 speedSq = v.SqrtLength();
+		const Float8 height = gravity.DotProduct(p);
+		const Float8 dynamic = Select(LoadLanes(inverseMasses_[i]) > zero, one, zero);
+		energy = energy + dynamic * LoadLanes(masses_[i]) * (Float8(0.5f) * speedSq - height);
+	}
+
+	LaneFloat result;
+	energy.Store(result.v);
+	return result;
+}
+
+Vec3 WorldBatch::GetPosition(const uint32_t world, const uint32_t body) const {
+	const LaneVec3& p = positions_[body];
+	return {p.x[world], p.y[world], p.z[world]};
+}
+
+Vec3 WorldBatch::GetVelocity(const uint32_t world, const uint32_t body) const {
+	const LaneVec3& v = velocities_[body];
+	return {v.x[world], v.y[world], v.z[world]};
+}
+
+void WorldBatch::IntegrateVelocities() {
+	const Float8 dt = deltaTime_;
+	const Vec3x8 gravity = LoadLanes(gravity_);
+	const Float8 linearDrag = LoadLanes(linearDrag_);
+	for (uint32_t i = 0; i < GetBodyCount(); ++i) {
+		const Vec3x8 v = LoadLanes(velocities_[i]);
+		const Float8 w = LoadLanes(inverseMasses_[i]);
+
+		// 重力 (質量比例) と速度比例の抵抗
+		const Float8 dynamic = Select(w > Float8(0.0f), Float8(1.0f), Float8(0.0f));
+		const Float8 drag = linearDrag * w;
+		StoreLanes(v + (gravity * dynamic - v * drag) * dt, velocities_[i]);
+	}
+}
+
+void WorldBatch::SolveConstraints() {
+	const Float8 dt = deltaTime_;
+	const Float8 invDt = 1.0f / deltaTime_;
+	const Float8 zero = 0.0f;
+	const Float8 one = 1.0f;
+	const Float8 penetrationSlop = LoadLanes(penetrationSlop_);
+	const Float8 baumgarteFactor = LoadLanes(baumgarteFactor_);
+
+	metrics_.iterations = 0;
+	Float8 maxPenetration = zero;
+
+	for (uint32_t iteration = 0; iteration < maxIterations_; ++iteration) {
+		for (const auto& [a, b] : pairs_) {
+			const Vec3x8 pa = LoadLanes(positions_[a]);
+			const Vec3x8 pb = LoadLanes(positions_[b]);
+			Vec3x8 va = LoadLanes(velocities_[a]);
+			Vec3x8 vb = LoadLanes(velocities_[b]);
+			Vec3x8 qa = LoadLanes(pseudoVelocities_[a]);
+			Vec3x8 qb = LoadLanes(pseudoVelocities_[b]);
+			const Float8 wa = LoadLanes(inverseMasses_[a]);
+			const Float8 wb = LoadLanes(inverseMasses_[b]);
+
+			const Vec3x8 delta = pb - pa;
+			const Float8 radiusSum = LoadLanes(radii_[a]) + LoadLanes(radii_[b]);
+			const Float8 distanceSq = delta.SqrtLength();
+			const Float8 distance = Sqrt(distanceSq);
+
+			// 重なっていないレーンは撃力0になるようマスクする
+			const Float8 inverseMassSum = wa + wb;
+			const Float8::Mask touching = (distanceSq < radiusSum * radiusSum) & (inverseMassSum > zero);
+			const Float8 active = Select(touching, one, zero);
+			const Float8 invW = Select(touching, one / inverseMassSum, zero);
+
+			// 中心が一致している場合は上に押し出す
+			const Float8::Mask apart = distance > zero;
+			const Float8 invDistance = Select(apart, one / distance, zero);
+			const Vec3x8 normal(delta.x * invDistance, Select(apart, delta.y * invDistance, one), delta.z * invDistance);
+			const Float8 penetration = (radiusSum - distance) * active;
+
+			if (iteration == 0) {
+				maxPenetration = Max(maxPenetration, penetration);
+			}
+
+			// スプリットインパルス
+			const Float8 error = Max(penetration - penetrationSlop, zero);
+			const Float8 bias = baumgarteFactor * error * invDt;
+			const Float8 pseudoRelative = (qb - qa).DotProduct(normal);
+			const Float8 velocityError = Max(bias - pseudoRelative, zero) * active;
+			const Float8 lambda = velocityError * invW;
+			qa -= normal * lambda * wa;
+			qb += normal * lambda * wb;
+
+			// 速度の撃力
+			const Float8 e = Min(LoadLanes(restitutions_[a]), LoadLanes(restitutions_[b]));
+			const Float8 relative = (vb - va).DotProduct(normal);
+			const Float8 j = -(one + e) * Min(relative, zero) * invW;
+			va -= normal * j * wa;
+			vb += normal * j * wb;
+
+			StoreLanes(va, velocities_[a]);
+			StoreLanes(vb, velocities_[b]);
+			StoreLanes(qa, pseudoVelocities_[a]);
+			StoreLanes(qb, pseudoVelocities_[b]);
+		}
+
+		for (uint32_t i = 0; i < GetBodyCount(); ++i) {
+			const uint32_t parent = parents_[i];
+			if (parent == kNoParent) {
+				continue;
+			}
+
+			const Vec3x8 pa = LoadLanes(positions_[parent]);
+			const Vec3x8 pb = LoadLanes(positions_[i]);
+			const Float8 wa = LoadLanes(inverseMasses_[parent]);
+			const Float8 wb = LoadLanes(inverseMasses_[i]);
+
+			const Vec3x8 delta = pb - pa;
+			const Float8 distance = delta.Length();
+			const Float8 inverseMassSum = wa + wb;
+
+			// 最大距離を超えたぶんを質量の逆数の比で戻す
+			const Float8 error = Max(distance - LoadLanes(maxDistances_[i]), zero);
+			const Float8::Mask valid = (error > zero) & (inverseMassSum > zero);
+			const Float8 scale = Select(valid, error / (distance * inverseMassSum), zero);
+			StoreLanes(pa + delta * scale * wa, positions_[parent]);
+			StoreLanes(pb - delta * scale * wb, positions_[i]);
+		}
+
+		// 距離拘束で位置が動くので、誤差は全部解き終えてから測り直す (PhysicsWorld::ComputeResidualと同じ)
+		Float8 residual = zero;
+		for (const auto& [a, b] : pairs_) {
+			const Vec3x8 delta = LoadLanes(positions_[b]) - LoadLanes(positions_[a]);
+			const Float8 radiusSum = LoadLanes(radii_[a]) + LoadLanes(radii_[b]);
+			const Float8 distanceSq = delta.SqrtLength();
+			const Float8 distance = Sqrt(distanceSq);
+			const Float8::Mask touching = (distanceSq < radiusSum * radiusSum) &
+				(LoadLanes(inverseMasses_[a]) + LoadLanes(inverseMasses_[b]) > zero);
+
+			const Float8::Mask apart = distance > zero;
+			const Float8 invDistance = Select(apart, one / distance, zero);
+			const Vec3x8 normal(delta.x * invDistance, Select(apart, delta.y * invDistance, one), delta.z * invDistance);
+			const Float8 separation =
+				(LoadLanes(pseudoVelocities_[b]) - LoadLanes(pseudoVelocities_[a])).DotProduct(normal) * dt;
+			const Float8 error = Max(radiusSum - distance - penetrationSlop - separation, zero);
+			residual = Max(residual, Select(touching, error, zero));
+		}
+		for (uint32_t i = 0; i < GetBodyCount(); ++i) {
+			const uint32_t parent = parents_[i];
+			if (parent == kNoParent) {
+				continue;
+			}
+			const Float8 distance = (LoadLanes(positions_[i]) - LoadLanes(positions_[parent])).Length();
+			const Float8::Mask dynamic = LoadLanes(inverseMasses_[parent]) + LoadLanes(inverseMasses_[i]) > zero;
+			residual = Max(residual, Select(dynamic, distance - LoadLanes(maxDistances_[i]), zero));
+		}
+
+		metrics_.iterations = iteration + 1;
+		residual.Store(metrics_.residual.v);
+
+		// 全レーンが収束したら打ち切る
+		float maxResidual = 0.0f;
+		for (uint32_t l = 0; l < worldCount_; ++l) {
+			maxResidual = std::max(maxResidual, metrics_.residual.v[l]);
+		}
+		if (maxResidual < tolerance_) {
+			break;
+		}
+	}
+	maxPenetration.Store(metrics_.maxPenetration.v);
+
+	// 速度の減衰は1ステップに1回だけ
+	const Float8 reductionFactor = LoadLanes(reductionFactor_);
+	for (uint32_t i = 0; i < GetBodyCount(); ++i) {
+		const uint32_t parent = parents_[i];
+		if (parent == kNoParent) {
+			continue;
+		}
+
+		const Vec3x8 delta = LoadLanes(positions_[i]) - LoadLanes(positions_[parent]);
+		const Vec3x8 va = LoadLanes(velocities_[parent]);
+		const Vec3x8 vb = LoadLanes(velocities_[i]);
+
+		const Float8 distanceSq = delta.SqrtLength();
+		const Float8 invDistance = Select(distanceSq > zero, one / Sqrt(distanceSq), zero);
+		const Vec3x8 normal = delta * invDistance;
+
+		const Float8 relative = (vb - va).DotProduct(normal);
+		const Float8 damping = relative * reductionFactor;
+		const Float8 dampA = Select(LoadLanes(inverseMasses_[parent]) > zero, damping, zero);
+		const Float8 dampB = Select(LoadLanes(inverseMasses_[i]) > zero, damping, zero);
+		StoreLanes(va + normal * dampA, velocities_[parent]);
+		StoreLanes(vb - normal * dampB, velocities_[i]);
+	}
+}
+
+void WorldBatch::IntegratePositions() {
+	const Float8 dt = deltaTime_;
+	const Vec3x8 zero(Vec3::zero);
+	for (uint32_t i = 0; i < GetBodyCount(); ++i) {
+		// 疑似速度は位置の補正にだけ使い、次のステップには持ち越さない
+		const Vec3x8 v = LoadLanes(velocities_[i]);
+		const Vec3x8 q = LoadLanes(pseudoVelocities_[i]);
+		StoreLanes(LoadLanes(positions_[i]) + (v + q) * dt, positions_[i]);
+		StoreLanes(zero, pseudoVelocities_[i]);
+	}
+}
@@ -0,0 +1,108 @@
+#pragma once
+#include <span>
+#include <vector>
+
+#include "SceneDescription.h"
+#include "SpatialGrid.h"
+
+// 1バッチで並べて進めるワールド数 (SIMDのレーン数)
+inline constexpr uint32_t kBatchLanes = 8;
+
+/// <summary>
+/// レーンごとのスカラー値
+/// </summary>
+struct alignas(32) LaneFloat {
+	float v[kBatchLanes];
+};
+
+/// <summary>
+/// レーンごとのベクトル (x, y, zを別々に並べる)
+/// </summary>
+struct alignas(32) LaneVec3 {
+	float x[kBatchLanes];
+	float y[kBatchLanes];
+	float z[kBatchLanes];
+};
+
+/// <summary>
+/// 1ステップ分のレーンごとの計測値
+/// </summary>
+struct BatchMetrics {
+	uint32_t iterations = 0; // 全レーン共通の反復回数
+	LaneFloat residual = {}; // 最後の反復の後に残った誤差の最大 (SolverStats::residualと同じ)
+	LaneFloat maxPenetration = {};
+	double stepMilliseconds = 0.0;
+};
+
+/// <summary>
+/// 同じ構造の小さなワールドを最大kBatchLanes個まとめて同時に進めます
+/// 剛体iの状態を全ワールド分隣り合わせに並べ (AoSoA)、
+/// 計算はVec3x8のパケットで書いているので、レーン方向にそのままSIMD命令になります
+/// </summary>
+class WorldBatch {
+public:
+	/// <summary>
+	/// シーンを読み込みます
+	/// すべてのシーンは剛体数と親子関係が同じである必要があります
+	/// ソルバーの設定はsettingsのdeltaTime・maxIterations・toleranceだけ先頭のシーンのものを共有します
+	/// 衝突レイヤー・マスクとparentCollisionも先頭のシーンのものを使います
+	/// トリガーの剛体はどれともぶつけません (重なりの通知は出しません)
+	/// </summary>
+	void Load(std::span<const SceneDescription> scenes);
+
+	void Step();
+
+	/// <summary>
+	/// 各ワールドの運動エネルギーと重力の位置エネルギーの和
+	/// </summary>
+	LaneFloat ComputeEnergy() const;
+
+	Vec3 GetPosition(uint32_t world, uint32_t body) const;
+	Vec3 GetVelocity(uint32_t world, uint32_t body) const;
+
+	uint32_t GetWorldCount() const {
+		return worldCount_;
+	}
+
+	uint32_t GetBodyCount() const {
+		return static_cast<uint32_t>(positions_.size());
+	}
+
+	const BatchMetrics& GetMetrics() const {
+		return metrics_;
+	}
+
+private:
+	void IntegrateVelocities();
+	void SolveConstraints();
+	void IntegratePositions();
+
+	uint32_t worldCount_ = 0;
+
+	// 剛体ごとに全レーン分
+	std::vector<LaneVec3> positions_;
+	std::vector<LaneVec3> velocities_;
+	std::vector<LaneVec3> pseudoVelocities_;
+	std::vector<LaneFloat> masses_;
+	std::vector<LaneFloat> inverseMasses_;
+	std::vector<LaneFloat> radii_;
+	std::vector<LaneFloat> restitutions_;
+	std::vector<LaneFloat> maxDistances_;
+
+	// 全ワールド共通の構造
+	std::vector<uint32_t> parents_;
+	std::vector<BodyPair> pairs_;
+
+	// レーンごとのパラメータ
+	LaneVec3 gravity_ = {};
+	LaneFloat linearDrag_ = {};
+	LaneFloat penetrationSlop_ = {};
+	LaneFloat baumgarteFactor_ = {};
+	LaneFloat reductionFactor_ = {};
+
+	float deltaTime_ = 0.0f;
+	uint32_t maxIterations_ = 0;
+	float tolerance_ = 0.0f;
+
+	BatchMetrics metrics_;
+};
@@ -0,0 +1,145 @@
+#include "WorldSweep.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "PhysicsWorld.h"
+#include "WorldBatch.h"
+
+namespace {
+	// 空の軸は「変えない」を表す1要素として扱う
+	std::span<const float> AxisOrDefault(const std::vector<float>& axis, const float& fallback) {
+		return axis.empty() ? std::span<const float>(&fallback, 1) : std::span<const float>(axis);
+	}
+
+	WorldReport RunWorld(const SceneDescription& scene, const uint32_t steps) {
+		PhysicsWorld world;
+		world.Load(scene);
+
+		WorldReport report;
+		report.initialEnergy = world.ComputeEnergy();
+
+		double totalMilliseconds = 0.0;
+		uint64_t totalIterations = 0;
+		for (uint32_t step = 0; step < steps; ++step) {
+			world.Step();
+
+			const StepMetrics& metrics = world.GetMetrics();
+			report.maxPenetration = std::max(report.maxPenetration, metrics.maxPenetration);
+			report.maxResidual = std::max(report.maxResidual, metrics.solver.residual);
+			report.maxStepMilliseconds = std::max(report.maxStepMilliseconds, metrics.stepMilliseconds);
+			totalMilliseconds += metrics.stepMilliseconds;
+			totalIterations += metrics.solver.iterations;
+		}
+
+		const float finalEnergy = world.ComputeEnergy();
+		report.energyDrift = (finalEnergy - report.initialEnergy) / std::max(std::abs(report.initialEnergy), 1.0f);
+		if (steps > 0) {
+			report.averageStepMilliseconds = totalMilliseconds / steps;
+			report.averageIterations = static_cast<float>(totalIterations) / static_cast<float>(steps);
+		}
+		return report;
+	}
+
+	// バッチ内のワールドの結果をoutReports[first] 以降に書き込む
+	void RunBatch(const std::span<const SceneDescription> scenes, const uint32_t first, const uint32_t steps,
+		std::vector<WorldReport>& outReports) {
+		WorldBatch batch;
+		batch.Load(scenes);
+
+		const uint32_t worldCount = batch.GetWorldCount();
+		const LaneFloat initialEnergy = batch.ComputeEnergy();
+
+		std::vector<WorldReport> reports(worldCount);
+		std::vector<uint64_t> totalIterations(worldCount, 0);
+		double totalMilliseconds = 0.0;
+		double maxMilliseconds = 0.0;
+
+		for (uint32_t step = 0; step < steps; ++step) {
+			batch.Step();
+
+			const BatchMetrics& metrics = batch.GetMetrics();
+			for (uint32_t l = 0; l < worldCount; ++l) {
+				reports[l].maxPenetration = std::max(reports[l].maxPenetration, metrics.maxPenetration.v[l]);
+				reports[l].maxResidual = std::max(reports[l].maxResidual, metrics.residual.v[l]);
+				totalIterations[l] += metrics.iterations;
+			}
+			totalMilliseconds += metrics.stepMilliseconds;
+			maxMilliseconds = std::max(maxMilliseconds, metrics.stepMilliseconds);
+		}
+
+		const LaneFloat finalEnergy = batch.ComputeEnergy();
+		for (uint32_t l = 0; l < worldCount; ++l) {
+			WorldReport& report = reports[l];
+			report.sceneIndex = first + l;
+			report.initialEnergy = initialEnergy.v[l];
+			report.energyDrift = (finalEnergy.v[l] - initialEnergy.v[l]) / std::max(std::abs(initialEnergy.v[l]), 1.0f);
+			// 時間はバッチ全体で共有しているのでワールド数で割って按分する
+			report.maxStepMilliseconds = maxMilliseconds / worldCount;
+			if (steps > 0) {
+				report.averageStepMilliseconds = totalMilliseconds / steps / worldCount;
+				report.averageIterations = static_cast<float>(totalIterations[l]) / static_cast<float>(steps);
+			}
+			outReports[first + l] = report;
+		}
+	}
+}
+
+std::vector<SceneDescription> MakeSweepScenes(const SceneDescription& base, const SweepAxes& axes) {
+	const float noRatio = 1.0f;
+	const float baseRestitution = base.bodies.empty() ? 0.0f : base.bodies.front().restitution;
+
+	const auto reductionFactors = AxisOrDefault(axes.reductionFactors, base.settings.reductionFactor);
+	const auto restitutions = AxisOrDefault(axes.restitutions, baseRestitution);
+	const auto massRatios = AxisOrDefault(axes.massRatios, noRatio);
+
+	std::vector<SceneDescription> scenes;
+	scenes.reserve(reductionFactors.size() * restitutions.size() * massRatios.size());
+
+	for (const float reduction : reductionFactors) {
+		for (const float restitution : restitutions) {
+			for (const float massRatio : massRatios) {
+				SceneDescription& scene = scenes.emplace_back(base);
+				scene.settings.reductionFactor = reduction;
+				for (size_t i = 0; i < scene.bodies.size(); ++i) {
+					BodyDescription& body = scene.bodies[i];
+					if (!axes.restitutions.empty()) {
+						body.restitution = restitution;
+					}
+					if (i % 2 == 1) {
+						body.mass *= massRatio;
+					}
+				}
+			}
+		}
+	}
+
+	return scenes;
+}
+
+void RunWorlds(const std::span<const SceneDescription> scenes, const uint32_t steps, ThreadPool& pool,
+	std::vector<WorldReport>& outReports) {
+	outReports.resize(scenes.size());
+
+	// ワールド同士は独立しているので1ワールドを1タスクとして配る
+	pool.ParallelFor(static_cast<uint32_t>(scenes.size()), 1, [&](const uint32_t begin, const uint32_t end) {
+		for (uint32_t i = begin; i < end; ++i) {
+			outReports[i] = RunWorld(scenes[i], steps);
+			outReports[i].sceneIndex = i;
+		}
+	});
+}
+
+void RunWorldsBatched(const std::span<const SceneDescription> scenes, const uint32_t steps, ThreadPool& pool,
+	std::vector<WorldReport>& outReports) {
+	outReports.resize(scenes.size());
+
+	const uint32_t batchCount = static_cast<uint32_t>((scenes.size() + kBatchLanes - 1) / kBatchLanes);
+	pool.ParallelFor(batchCount, 1, [&](const uint32_t begin, const uint32_t end) {
+		for (uint32_t b = begin; b < end; ++b) {
+			const uint32_t first = b * kBatchLanes;
+			const uint32_t count = std::min(kBatchLanes, static_cast<uint32_t>(scenes.size()) - first);
+			RunBatch(scenes.subspan(first, count), first, steps, outReports);
+		}
+	});
+}
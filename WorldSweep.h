@@ -0,0 +1,48 @@
+#pragma once
+#include <span>
+#include <vector>
+
+#include "SceneDescription.h"
+#include "ThreadPool.h"
+
+/// <summary>
+/// 1つのワールドを最後まで回した結果
+/// </summary>
+struct WorldReport {
+	uint32_t sceneIndex = 0;
+	float initialEnergy = 0.0f;
+	float energyDrift = 0.0f; // (最終エネルギー - 初期エネルギー) / max(|初期エネルギー|, 1)
+	float maxPenetration = 0.0f; // 全ステップを通した最大めり込み
+	float maxResidual = 0.0f; // 全ステップを通した反復後の最大誤差 (SolverStats::residual、長さ)
+	float averageIterations = 0.0f;
+	double averageStepMilliseconds = 0.0;
+	double maxStepMilliseconds = 0.0;
+};
+
+/// <summary>
+/// パラメータスイープの各軸
+/// 空の軸は基準シーンの値のまま変えません
+/// </summary>
+struct SweepAxes {
+	std::vector<float> reductionFactors;
+	std::vector<float> restitutions;
+	std::vector<float> massRatios; // 奇数番目の剛体の質量に掛ける倍率
+};
+
+/// <summary>
+/// 基準シーンに対して各軸の全組み合わせのシーンを作ります
+/// </summary>
+std::vector<SceneDescription> MakeSweepScenes(const SceneDescription& base, const SweepAxes& axes);
+
+/// <summary>
+/// 各シーンから独立したワールドを作り、スレッドプールで並列にsteps回進めて計測します
+/// </summary>
+void RunWorlds(std::span<const SceneDescription> scenes, uint32_t steps, ThreadPool& pool,
+	std::vector<WorldReport>& outReports);
+
+/// <summary>
+/// RunWorldsと同じ計測を、同じ構成のシーンをkBatchLanes個ずつ束ねたWorldBatchで行います
+/// 全シーンの剛体数と親子関係が同じである必要があります
+/// </summary>
+void RunWorldsBatched(std::span<const SceneDescription> scenes, uint32_t steps, ThreadPool& pool,
+	std::vector<WorldReport>& outReports);
@@ -1,9 +1,11 @@
+#include "AllocationTracker.h"
 #include "Audio.h"
 #include "AxisIndicator.h"
 #include "DirectXCommon.h"
 #include "GameScene.h"
 #include "ImGuiManager.h"
 #include "PrimitiveDrawer.h"
+#include "Profiler.h"
 #include "TextureManager.h"
 #include "WinApp.h"
 
@@ -63,6 +65,10 @@ int WINAPI WinMain(HINSTANCE, HINSTANCE, LPSTR, int) {
 
 	// メインループ
 	while (true) {
+		// フレームの区切り
+		PROFILE_FRAME();
+		ALLOCATION_FRAME();
+
 		// メッセージ処理
 		if (win->ProcessMessage()) {
 			break;
@@ -71,9 +77,17 @@ int WINAPI WinMain(HINSTANCE, HINSTANCE, LPSTR, int) {
 		// ImGui受付開始
 		imguiManager->Begin();
 		// 入力関連の毎フレーム処理
-		input->Update();
+		{
+			PROFILE_ZONE("Input::Update");
+			ALLOCATION_SCOPE("Input::Update");
+			input->Update();
+		}
 		// ゲームシーンの毎フレーム処理
-		gameScene->Update();
+		{
+			PROFILE_ZONE("GameScene::Update");
+			ALLOCATION_SCOPE("GameScene::Update");
+			gameScene->Update();
+		}
 		// 軸表示の更新
 		axisIndicator->Update();
 		// ImGui受付終了
@@ -82,15 +96,26 @@ int WINAPI WinMain(HINSTANCE, HINSTANCE, LPSTR, int) {
 		// 描画開始
 		dxCommon->PreDraw();
 		// ゲームシーンの描画
-		gameScene->Draw();
+		{
+			ALLOCATION_SCOPE("GameScene::Draw");
+			gameScene->Draw();
+		}
 		// 軸表示の描画
 		axisIndicator->Draw();
 		// プリミティブ描画のリセット
-		primitiveDrawer->Reset();
+		{
+			PROFILE_ZONE("PrimitiveDrawer::Reset");
+			ALLOCATION_SCOPE("PrimitiveDrawer::Reset");
+			primitiveDrawer->Reset();
+		}
 		// ImGui描画
 		imguiManager->Draw();
 		// 描画終了
-		dxCommon->PostDraw();
+		{
+			PROFILE_ZONE("DirectXCommon::PostDraw");
+			ALLOCATION_SCOPE("DirectXCommon::PostDraw");
+			dxCommon->PostDraw();
+		}
 	}
 
 	// 各種解放
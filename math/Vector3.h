@@ -1,5 +1,6 @@
 #pragma once
 #include <cassert>
+#include <concepts>
 
 #include "Vec3.h"
 
@@ -11,70 +12,60 @@ struct Vector3 final {
 	float y;
 	float z;
 
-	Vec3 ConvertToVec3() const;
+	/// <summary>
+	/// 同じ並びのVec3に変換します (メンバをそのまま写すだけです)
+	/// </summary>
+	constexpr Vec3 ConvertToVec3() const {
+		return {x, y, z};
+	}
+
+	/// <summary>
+	/// Vec3を代入します
+	/// ({x, y, z} の代入がVector3のコピー代入と曖昧にならないようテンプレートにしています)
+	/// </summary>
+	template <std::same_as<Vec3> T>
+	constexpr Vector3& operator=(const T& rhs) {
+		x = rhs.x;
+		y = rhs.y;
+		z = rhs.z;
+		return *this;
+	}
+
+	constexpr Vector3 operator+(const Vec3& rhs) const {
+		return {x + rhs.x, y + rhs.y, z + rhs.z};
+	}
+
+	constexpr Vector3 operator-(const Vec3& rhs) const {
+		return {x - rhs.x, y - rhs.y, z - rhs.z};
+	}
 
-	Vector3 operator+(const Vec3& rhs) const;
-	Vector3 operator-(const Vec3& rhs) const;
-	Vector3 operator*(const Vec3& rhs) const;
-	Vector3 operator/(const Vec3& rhs) const;
+	constexpr Vector3 operator*(const Vec3& rhs) const {
+		return {x * rhs.x, y * rhs.y, z * rhs.z};
+	}
+
+	constexpr Vector3 operator/(const Vec3& rhs) const {
+		return {x / rhs.x, y / rhs.y, z / rhs.z};
+	}
 
 	/// <summary>
 	/// 添字演算子
 	/// </summary>
-	float& operator[](const int index) {
+	constexpr float& operator[](const int index) {
 		assert(index <= 2 && index >= 0 && "Index out of range");
-		if (index == 0) {
-			return x;
-		}
-		if (index == 1) {
-			return y;
-		}
-		if (index == 2) {
-			return z;
-		}
-		static float ret = 0.0f;
-		return ret;
+		return this->*kElements[index];
 	}
 
 	/// <summary>
 	/// 添字演算子
 	/// </summary>
-	const float& operator[](const int index) const {
+	constexpr const float& operator[](const int index) const {
 		assert(index <= 2 && index >= 0 && "Index out of range");
-		if (index == 0) {
-			return x;
-		}
-		if (index == 1) {
-			return y;
-		}
-		if (index == 2) {
-			return z;
-		}
-		static constexpr float ret = 0.0f;
-		return ret;
-	}
-};
-
-inline Vec3 Vector3::ConvertToVec3() const {
-	Vec3 ret;
-	for (int i = 0; i < 3; ++i) {
-		ret[i] = (*this)[i];
+		return this->*kElements[index];
 	}
-	return ret;
-}
-
-inline Vector3 Vector3::operator+(const Vec3& rhs) const {
-	return {x + rhs.x, y + rhs.y, z + rhs.z};
-}
 
-inline Vector3 Vector3::operator-(const Vec3& rhs) const {
-	return {x - rhs.x, y - rhs.y, z - rhs.z};
-}
-
-inline Vector3 Vector3::operator*(const Vec3& rhs) const {
-	return {x * rhs.x, y * rhs.y, z * rhs.z};
-}
+private:
+	static constexpr float Vector3::* kElements[3] = {&Vector3::x, &Vector3::y, &Vector3::z};
+};
 
-inline Vector3 Vector3::operator/(const Vec3& rhs) const {
-	return {x / rhs.x, y / rhs.y, z / rhs.z};
-}
\ No newline at end of file
+// Vec3と同じ並びなので、変換はメンバの写しだけで済みます
+static_assert(sizeof(Vector3) == sizeof(Vec3) && alignof(Vector3) == alignof(Vec3));
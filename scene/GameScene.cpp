@@ -1,14 +1,18 @@
 #include "GameScene.h"
 #include "TextureManager.h"
+#include <array>
 #include <cassert>
 #include <DebugText.h>
 
 #include "AxisIndicator.h"
 #include "PrimitiveDrawer.h"
+#include "Profiler.h"
+#include "ProfilerOverlay.h"
+#include "ThreadPool.h"
 
 void DrawGrid();
+Mat4 ToMat4(const Matrix4x4& matrix);
 void RenderOutliner(const std::shared_ptr<Object>& object, std::shared_ptr<Object>& selectedObject);
-Vector3 TransformNormal(Vector3 v, const Mat4& m);
 
 GameScene::GameScene() {}
 
@@ -32,49 +36,37 @@ void GameScene::Initialize() {
 	//-----------------------------------------------------------------------------
 	// 
 	//-----------------------------------------------------------------------------
-	constexpr int numChildren = 5;
-	auto circleRoot = std::make_shared<Sphere>("SphereRoot");
-	circleRoot->SetTransform(
-		Vec3::zero,
-		Vec3::zero,
-		Vec3::one
-	);
-	circleRoot->SetModel(sphere_.get());
-	circles.push_back(circleRoot);
-	objects.push_back(circleRoot);
-
-	auto parent = circleRoot;
-	for (int i = 1; i <= numChildren; ++i) {
-		auto child = std::make_shared<Sphere>("child" + std::to_string(i));
-		child->SetTransform(
-			{child->GetRadius() * 2.0f * i, 0.0f, 0.0f},
+	constexpr uint32_t numChildren = 5;
+	const SceneDescription scene = SceneDescription::MakeChain(numChildren);
+
+	// シーンの記述どおりに球を作る (circlesの並びはワールドの剛体のハンドルと同じ)
+	for (const BodyDescription& body : scene.bodies) {
+		auto circle = std::make_shared<Sphere>(body.name, "", true, body.radius);
+		circle->SetTransform(
+			body.position,
 			Vec3::zero,
 			Vec3::one
 		);
-		parent->AddChild(child);
-		child->Initialize(child->GetName());
-		child->SetModel(sphere_.get());
-		circles.push_back(child);
-		parent = child;
+
+		if (body.parent == kNoParent) {
+			objects.push_back(circle);
+		} else {
+			circles[body.parent]->AddChild(circle);
+			circle->Initialize(circle->GetName());
+		}
+
+		circle->SetModel(sphere_.get());
+		circles.push_back(circle);
+
+		// 球の座標は物理ワールドで解いたワールド座標なので、行列の上では親を持たない
+		transforms_.Add(circle->GetTransform());
 	}
 
-	// 別の子
-	//auto child2 = std::make_shared<Sphere>("CircleChild2");
-	//child2->SetTransform({-5.0f,0.0f,0.0f}, Vec3::zero, Vec3::one);
-	//circleRoot->GetChildren()[0]->AddChild(child2);
-	//child2->Initialize(child2->GetName());
-	//child2->SetModel(sphere_.get());
-	//circles.push_back(child2);
-
-	auto otherCircle = std::make_shared<Sphere>("OtherSphere");
-	otherCircle->SetModel(sphere_.get());
-	otherCircle->SetTransform(
-		{-4.0f,0.0f,0.0f},
-		Vec3::zero,
-		Vec3::one
-	);
-	circles.push_back(otherCircle);
-	objects.push_back(otherCircle);
+	world_.Load(scene);
+	// 重力は元のRigidbody::AddForceと同じく質量によらない一定の力として加え、Massの編集で落ち方が変わらないようにする
+	ForceGeneratorSet& forceGenerators = world_.GetForceGenerators();
+	forceGenerators.gravities[0].acceleration = Vec3::zero;
+	forceGenerators.uniformForces.push_back({{0.0f, -gravity, 0.0f}, BodySelection::All()});
 
 	// カメラを作成
 	camera = std::make_shared<Camera>();
@@ -89,7 +81,7 @@ void GameScene::Update() {
 	if (Input::GetInstance()->IsPressMouse(1)) {
 		Input* input = Input::GetInstance();
 		Input::MouseMove mouseMove = input->GetMouseMove();
-		Vec3 camRot = camera->GetTransform().rotation;
+		Vec3 camRot = camera->GetEulerRotation();
 
 		// Vec2にする
 		Vec2 mouseDelta = {static_cast<float>(mouseMove.lX),static_cast<float>(mouseMove.lY)};
@@ -193,41 +185,32 @@ void GameScene::Update() {
 	}
 #pragma endregion
 
-	// ソルバーの更新
-	for (size_t i = 0; i < circles.size(); ++i) {
-		for (size_t j = i + 1; j < circles.size(); ++j) {
-			if (circles[i]->IsCollide(*circles[j])) {
-				circles[i]->ResolveCollision(*circles[j]);
-			}
-		}
-	}
+	// 物理ワールドの更新
+	PushBodies();
+	world_.GetSettings().reductionFactor = reductionFactor;
+	world_.GetForceGenerators().uniformForces[0].force = {0.0f, -gravity, 0.0f};
+	world_.Step(ThreadPool::GetInstance());
+	PullBodies();
 
 	// オブジェクトの更新
 	for (auto& o : objects) {
 		o->Update();
 	}
 
+	UpdateTransforms();
+
 	if (lookAtObject) {
 		if (selectedObject && selectedObject != camera) {
-			Vector3 newPos;
 			auto circle = dynamic_cast<Sphere*>(selectedObject.get());
 
 			// 追従対象からカメラまでのオフセット
-			Vector3 offset = {0.0f, 0.0f , circle->GetRadius() - 30.0f};
+			const Vec3 offset = {0.0f, 0.0f , circle->GetRadius() - 30.0f};
 
 			const Mat4 x = Mat4::RotateX(viewProjection_.rotation_.x);
 			const Mat4 y = Mat4::RotateY(viewProjection_.rotation_.y);
 
-			// オフセットをカメラの回転に合わせて回転させる
-			Vector3 newOffset = TransformNormal(offset, x * y);
-			for (int i = 0; i < 3; ++i) {
-				offset[i] = newOffset[i];
-			}
-
-			// 座標をコピーしてオフセット分ずらす
-			for (int i = 0; i < 3; ++i) {
-				newPos[i] = selectedObject.get()->GetWorldTransform()->translation_[i] + offset[i];
-			}
+			// オフセットをカメラの回転に合わせて回転させ、座標をオフセット分ずらす
+			const Vector3 newPos = selectedObject->GetWorldTransform()->translation_ + Mat4::TransformNormal(offset, x * y);
 
 			camera->SetTransform(
 				newPos.ConvertToVec3(),
@@ -249,6 +232,7 @@ void GameScene::Update() {
 	viewProjection_.matProjection = camera->GetViewProjection()->matProjection;
 	viewProjection_.TransferMatrix();
 
+	CullSpheres();
 
 	ImGui::Begin("Outliner");
 
@@ -271,6 +255,44 @@ void GameScene::Update() {
 
 		if (ImGui::BeginTabItem("World")) {
 			ImGui::DragFloat("Gravity", &gravity, 1.0f);
+			if (ImGui::IsItemHovered()) {
+				ImGui::SetTooltip("Constant downward force on every sphere (not scaled by mass).");
+			}
+			ImGui::DragFloat("Drag", &world_.GetForceGenerators().linearDrags[0].coefficient, 0.01f, 0.0f, 100.0f);
+
+			SolverSettings& settings = world_.GetSettings();
+			ImGui::DragFloat("PenetrationSlop", &settings.penetrationSlop, 0.001f, 0.0f, 1.0f);
+			ImGui::DragFloat("Baumgarte", &settings.baumgarteFactor, 0.01f, 0.0f, 1.0f);
+			const uint32_t minIterations = 1;
+			const uint32_t maxIterations = 64;
+			ImGui::DragScalar("MaxIterations", ImGuiDataType_U32, &settings.maxIterations, 1.0f, &minIterations, &maxIterations);
+			ImGui::DragFloat("Tolerance", &settings.tolerance, 0.0001f, 0.0f, 1.0f, "%.4f");
+			if (ImGui::IsItemHovered()) {
+				ImGui::SetTooltip("Stop iterating once the largest error left after an iteration\n"
+					"(penetration beyond the slop, or link overstretch) falls below this length.");
+			}
+			const uint32_t maxReorderInterval = 600;
+			ImGui::DragScalar("ReorderInterval", ImGuiDataType_U32, &settings.reorderInterval, 1.0f, nullptr, &maxReorderInterval);
+			int broadphase = static_cast<int>(settings.broadphase);
+			if (ImGui::Combo("Broadphase", &broadphase, kBroadphaseNames, static_cast<int>(std::size(kBroadphaseNames)))) {
+				settings.broadphase = static_cast<BroadphaseType>(broadphase);
+			}
+			if (settings.broadphase == BroadphaseType::Verlet) {
+				ImGui::DragFloat("VerletSkin", &settings.verletSkin, 0.01f, 0.0f, 10.0f);
+			}
+			ImGui::Checkbox("ParentCollision", &settings.parentCollision);
+			bool contactEvents = settings.contactEventThreshold >= 0.0f;
+			if (ImGui::Checkbox("ContactEvents", &contactEvents)) {
+				settings.contactEventThreshold = contactEvents ? 0.0f : -1.0f;
+			}
+			if (contactEvents) {
+				ImGui::DragFloat("MinImpulse", &settings.contactEventThreshold, 0.01f, 0.0f, 100.0f);
+			}
+
+			const StepMetrics& metrics = world_.GetMetrics();
+			ImGui::Text("Iterations: %u  Residual: %.5f", metrics.solver.iterations, metrics.solver.residual);
+			ImGui::Text("Pairs: %u  Triggers: %u  Contacts: %u  Step: %.3f ms", metrics.pairCount,
+				metrics.triggerPairCount, metrics.contactEventCount, metrics.stepMilliseconds);
 			ImGui::Checkbox("Look at Object", &lookAtObject);
 			ImGui::Checkbox("DrawDebug", &bDrawDebug);
 			ImGui::EndTabItem();
@@ -280,9 +302,12 @@ void GameScene::Update() {
 	}
 
 	ImGui::End();
+
+	DrawProfilerOverlay();
 }
 
 void GameScene::Draw() {
+	PROFILE_ZONE("GameScene::Draw");
 
 	// コマンドリストの取得
 	ID3D12GraphicsCommandList* commandList = dxCommon_->GetCommandList();
@@ -340,10 +365,114 @@ void GameScene::Draw() {
 #pragma endregion
 }
 
+void GameScene::PushBodies() {
+	BodyArrays& bodies = world_.GetBodies();
+	for (uint32_t i = 0; i < bodies.Size(); ++i) {
+		// circlesはLoadした順 (ハンドル順) なので、ワールドが並べ替えた先のスロットに書く
+		const uint32_t slot = world_.GetBodySlot(i);
+		// エディタで書き換えられた値も含めて毎フレーム渡す
+		const Sphere& circle = *circles[i];
+		const Rigidbody& rb = circle.GetRigidbody();
+		const WorldTransform* transform = circles[i]->GetWorldTransform();
+		bodies.positions[slot] = transform->translation_.ConvertToVec3();
+		bodies.velocities[slot] = rb.GetVelocity();
+		bodies.masses[slot] = rb.GetMass();
+		bodies.inverseMasses[slot] = circle.GetInverseMass();
+		bodies.radii[slot] = circle.GetRadius() * transform->scale_.x;
+		bodies.restitutions[slot] = rb.GetReboundCoefficient();
+		bodies.maxDistances[slot] = circle.GetMaxDistanceToParent();
+	}
+}
+
+void GameScene::PullBodies() {
+	const BodyArrays& bodies = world_.GetBodies();
+	for (uint32_t i = 0; i < bodies.Size(); ++i) {
+		const uint32_t slot = world_.GetBodySlot(i);
+		WorldTransform* transform = circles[i]->GetWorldTransform();
+		transform->translation_ = bodies.positions[slot];
+		circles[i]->SetVelocity(bodies.velocities[slot]);
+	}
+}
+
+void GameScene::UpdateTransforms() {
+	// 値が変わった球だけが計算し直しの対象になる
+	for (uint32_t i = 0; i < circles.size(); ++i) {
+		transforms_.SetLocal(i, circles[i]->GetTransform());
+	}
+
+	transforms_.UpdateWorldMatrices(ThreadPool::GetInstance());
+
+	// 計算し直した行列だけを転送する
+	for (uint32_t i = 0; i < circles.size(); ++i) {
+		if (!transforms_.WasUpdated(i)) {
+			continue;
+		}
+
+		WorldTransform* transform = circles[i]->GetWorldTransform();
+		const Mat4& world = transforms_.GetWorldMatrix(i);
+		for (int row = 0; row < 4; ++row) {
+			for (int column = 0; column < 4; ++column) {
+				transform->matWorld_.m[row][column] = world.m[row][column];
+			}
+		}
+		transform->TransferMatrix();
+	}
+}
+
+void GameScene::CullSpheres() {
+	PROFILE_ZONE("GameScene::CullSpheres");
+
+	// 中心をまとめてビュー空間へ移す (ビュー行列はアフィンなのでw除算はいらない)
+	viewCenters_.resize(circles.size());
+	for (uint32_t i = 0; i < circles.size(); ++i) {
+		viewCenters_[i] = circles[i]->GetWorldTransform()->translation_.ConvertToVec3();
+	}
+	Mat4::TransformPoints(viewCenters_, ToMat4(viewProjection_.matView), viewCenters_, ThreadPool::GetInstance());
+
+	// 射影行列の列から、ビュー空間での左右上下と手前の面を取り出す (Gribb-Hartmann)
+	// 奥の面は遠くの球を消したくないので使わない
+	const Mat4 projection = ToMat4(viewProjection_.matProjection);
+	const auto column = [&projection](const int j) {
+		return std::array<float, 4>{projection.m[0][j], projection.m[1][j], projection.m[2][j], projection.m[3][j]};
+	};
+	const std::array<float, 4> x = column(0);
+	const std::array<float, 4> y = column(1);
+	const std::array<float, 4> z = column(2);
+	const std::array<float, 4> w = column(3);
+	std::array<std::array<float, 4>, 5> planes = {};
+	for (int k = 0; k < 4; ++k) {
+		planes[0][k] = w[k] + x[k];
+		planes[1][k] = w[k] - x[k];
+		planes[2][k] = w[k] + y[k];
+		planes[3][k] = w[k] - y[k];
+		planes[4][k] = z[k]; // 深度が0から1の射影
+	}
+	for (std::array<float, 4>& plane : planes) {
+		const float length = Vec3{plane[0], plane[1], plane[2]}.Length();
+		for (float& value : plane) {
+			value /= length;
+		}
+	}
+
+	for (uint32_t i = 0; i < circles.size(); ++i) {
+		const Vec3& center = viewCenters_[i];
+		const float radius = circles[i]->GetRadius() * circles[i]->GetWorldTransform()->scale_.x;
+		bool visible = true;
+		for (const std::array<float, 4>& plane : planes) {
+			if (plane[0] * center.x + plane[1] * center.y + plane[2] * center.z + plane[3] < -radius) {
+				visible = false;
+				break;
+			}
+		}
+		circles[i]->SetVisible(visible);
+	}
+}
+
 void RenderOutliner(const std::shared_ptr<Object>& object, std::shared_ptr<Object>& selectedObject) {
 	ImGuiTreeNodeFlags nodeFlags = ImGuiTreeNodeFlags_OpenOnArrow | ImGuiTreeNodeFlags_OpenOnDoubleClick;
 
-	if (object->GetChildren().empty()) {
+	const std::span<const std::shared_ptr<Object>> children = object->Children();
+	if (children.empty()) {
 		nodeFlags |= ImGuiTreeNodeFlags_Leaf;
 	}
 
@@ -357,8 +486,8 @@ void RenderOutliner(const std::shared_ptr<Object>& object, std::shared_ptr<Objec
 		selectedObject = object;
 	}
 
-	if (nodeOpen && !object->GetChildren().empty()) {
-		for (const auto& child : object->GetChildren()) {
+	if (nodeOpen && !children.empty()) {
+		for (const auto& child : children) {
 			RenderOutliner(child, selectedObject);
 		}
 		ImGui::TreePop();
@@ -367,11 +496,14 @@ void RenderOutliner(const std::shared_ptr<Object>& object, std::shared_ptr<Objec
 	}
 }
 
-Vector3 TransformNormal(const Vector3 v, const Mat4& m) {
-	return {
-		v.x * m.m[0][0] + v.y * m.m[1][0] + v.z * m.m[2][0], v.x * m.m[0][1] + v.y * m.m[1][1] + v.z * m.m[2][1],
-		v.x * m.m[0][2] + v.y * m.m[1][2] + v.z * m.m[2][2]
-	};
+Mat4 ToMat4(const Matrix4x4& matrix) {
+	Mat4 result;
+	for (int row = 0; row < 4; ++row) {
+		for (int column = 0; column < 4; ++column) {
+			result.m[row][column] = matrix.m[row][column];
+		}
+	}
+	return result;
 }
 
 void DrawGrid() {
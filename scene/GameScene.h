@@ -5,7 +5,9 @@
 #include "DirectXCommon.h"
 #include "Input.h"
 #include "Model.h"
+#include "PhysicsWorld.h"
 #include "Sprite.h"
+#include "TransformHierarchy.h"
 #include "ViewProjection.h"
 #include "WorldTransform.h"
 
@@ -40,6 +42,34 @@ public: // メンバ関数
 	/// </summary>
 	void Draw();
 
+	/// <summary>
+	/// 近傍探索用の空間分割を取得
+	/// </summary>
+	SpatialGrid& GetSpatialGrid() {
+		return world_.GetSpatialGrid();
+	}
+
+private: // メンバ関数
+	/// <summary>
+	/// 球の状態をワールドに渡す
+	/// </summary>
+	void PushBodies();
+
+	/// <summary>
+	/// ワールドの結果を球に戻す
+	/// </summary>
+	void PullBodies();
+
+	/// <summary>
+	/// 球のワールド行列を階層でまとめて計算して転送する
+	/// </summary>
+	void UpdateTransforms();
+
+	/// <summary>
+	/// 視錐台の外にある球を描画しないようにする
+	/// </summary>
+	void CullSpheres();
+
 private: // メンバ変数
 	DirectXCommon* dxCommon_ = nullptr;
 	Input* input_ = nullptr;
@@ -59,6 +89,15 @@ private: // メンバ変数
 	std::vector<std::shared_ptr<Object>> objects;
 	std::vector<std::shared_ptr<Sphere>> circles;
 
+	// circlesと同じ並びで剛体を持つ物理ワールド
+	PhysicsWorld world_;
+
+	// circlesと同じ並び (ハンドル) でトランスフォームを持つ階層
+	TransformHierarchy transforms_;
+
+	// カリング用に、球の中心をビュー空間へ変換した作業配列 (circlesと同じ並び)
+	std::vector<Vec3> viewCenters_;
+
 	// 選択されたオブジェクトのポインタがここに格納される
 	std::shared_ptr<Object> selectedObject = nullptr;
 